@@ -33,48 +33,127 @@
 #include <WebKit2/WKPage.h>
 #include <WebKit2/WKPreferences.h>
 #include <WebKit2/WKPreferencesPrivate.h>
-#include <GL/gl.h>
 #include <cairo.h>
 #include <glib.h>
+#include <glib-unix.h>
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
 #include <unistd.h>
 #include <cstdlib>
+#include <iostream>
 #include <libgen.h>
 #include <limits.h>
+#include <signal.h>
 #include <string>
 #include <vector>
 
 #include "FatalError.h"
+#include "Hud.h"
 #include "InjectedBundleGlue.h"
+#include "InputRecorder.h"
+#include "MainLoopScheduling.h"
 #include "Tab.h"
-
-Browser::Browser(const std::vector<std::string>& urls)
-    : m_displayUpdateScheduled(false)
-    , m_window(DesktopWindow::create(this, 1024, 600))
+#include "TabPool.h"
+
+// How long a tab switched to may take to ask for its first paint before it's painted anyway.
+static const guint tabPaintTimeout = 500;
+// A restored tab has to load its page again, its thumbnail is kept longer meanwhile.
+static const guint restoredTabPaintTimeout = 3000;
+// How often hidden tabs are considered for discarding.
+static const guint discardCheckInterval = 10000;
+// Inputs having no visible effect wait for whatever frame comes next, there's no point in keeping many.
+static const size_t maxPendingInputs = 256;
+// Input presented later than this many refresh intervals most likely didn't cause the frame.
+static const int maxInputLatencyFrames = 4;
+
+Browser::Browser(const BrowserOptions& options)
+    : m_needsFullRepaint(true)
+    , m_windowOccluded(false)
+    , m_hudVisible(options.showHud)
+    , m_displayRequests(0)
+    , m_screenshotRequested(false)
+    , m_tabAwaitingPaint(false)
+    , m_previousTab(-1)
+    , m_tabSwitchStart(0)
+    , m_tabPaintTimeoutSource(0)
+    , m_tabSwitches(0)
+    , m_tabSwitchTimeouts(0)
+    , m_tabSwitchLatencyTotal(0)
+    , m_tabSwitchLatencyMax(0)
+    , m_tabRestoring(false)
+    , m_discardSource(0)
+    , m_tabDiscards(0)
+    , m_tabRestores(0)
+    , m_tabRestoresPainted(0)
+    , m_tabRestoreLatencyTotal(0)
+    , m_tabRestoreLatencyMax(0)
+    , m_window(options.headless ? DesktopWindow::createHeadless(this, 1024, 600) : DesktopWindow::create(this, 1024, 600, true, options.presentation))
+    , m_inputRecorder(0)
+    , m_inputReplayer(0)
+    , m_frameScheduler(new FrameScheduler(m_window, this))
+    , m_compositor(0)
     , m_glue(0)
     , m_uiFocused(true)
     , m_toolBarHeight(0)
+    , m_popupHeight(0)
+    , m_tabPool(0)
+    , m_processModel(options.processModel, options.maxProcesses)
+    , m_loadScheduler(options.maxConcurrentLoads)
     , m_currentTab(-1)
-    , m_initialUrls(urls)
+    , m_options(options)
 {
+    if (!options.replayInput.empty()) {
+        m_inputReplayer = new InputReplayer(options.replayInput, m_window, this, this, options.replayPaced);
+        m_window->setClient(m_inputReplayer);
+    } else if (!options.recordInput.empty()) {
+        m_inputRecorder = new InputRecorder(options.recordInput, this);
+        m_window->setClient(m_inputRecorder);
+    }
+
+    if (options.swapInterval >= 0 && !m_window->setSwapInterval(options.swapInterval))
+        std::cerr << "Could not set the swap interval." << std::endl;
+    // Takes the GL context away from this thread when threaded.
+    m_compositor = new Compositor(m_window, this, options.threadedCompositor, options.recordVideo);
+
     m_mainLoop = g_main_loop_new(0, false);
+    g_unix_signal_add_full(schedulingPriority(BackgroundClass), SIGUSR1, [](gpointer browser) -> gboolean {
+        reinterpret_cast<Browser*>(browser)->dumpStatistics();
+        return true;
+    }, this, 0);
+
+    if (options.liveTabs) {
+        m_discardSource = scheduleTimeout(BackgroundClass, discardCheckInterval, [](gpointer browser) -> gboolean {
+            reinterpret_cast<Browser*>(browser)->discardHiddenTabs();
+            return true;
+        }, this);
+    }
 
     initUi();
 }
 
 Browser::~Browser()
 {
+    if (m_tabPaintTimeoutSource)
+        g_source_remove(m_tabPaintTimeoutSource);
+    if (m_discardSource)
+        g_source_remove(m_discardSource);
+    delete m_frameScheduler;
+    delete m_compositor;
+
     for (std::pair<const int, Tab*> p : m_tabs)
         delete p.second;
     m_tabs.clear();
+    delete m_tabPool;
     WKRelease(m_contentPageGroup);
 
     g_main_loop_unref(m_mainLoop);
     WKRelease(m_uiView);
     WKRelease(m_uiContext);
     delete m_window;
+    delete m_inputRecorder;
+    delete m_inputReplayer;
     delete m_glue;
 }
 
@@ -130,8 +209,10 @@ void Browser::initUi()
     std::memset(&client, 0, sizeof(WKViewClientV0));
     client.base.version = 0;
     client.base.clientInfo = this;
-    client.viewNeedsDisplay = [](WKViewRef, WKRect, const void* client) {
-        ((Browser*)client)->scheduleUpdateDisplay();
+    client.viewNeedsDisplay = [](WKViewRef, WKRect rect, const void* client) {
+        Browser* self = (Browser*)client;
+        self->m_uiDamage.add(rect);
+        self->scheduleUpdateDisplay();
     };
     client.webProcessCrashed = [](WKViewRef, WKURLRef, const void*) {
         puts("UI Webprocess crashed :-(");
@@ -141,7 +222,7 @@ void Browser::initUi()
     WKViewInitialize(m_uiView);
     WKViewSetIsFocused(m_uiView, true);
     WKViewSetIsVisible(m_uiView, true);
-    WKViewSetSize(m_uiView, m_window->size());
+    updateUiViewSize();
 
     NIXViewClientV0 nixClient;
     std::memset(&nixClient, 0, sizeof(nixClient));
@@ -159,8 +240,11 @@ void Browser::initUi()
     m_glue->bind("_requestTab", this, &Browser::requestTab);
     m_glue->bind("_closeTab", this, &Browser::closeTab);
     m_glue->bind("_toolBarHeightChanged", this, &Browser::toolBarHeightChanged);
+    m_glue->bind("_popupHeightChanged", this, &Browser::popupHeightChanged);
     m_glue->bind("_setCurrentTab", this, &Browser::setCurrentTab);
     m_glue->bind("_loadUrl", this, &Browser::loadUrlOnCurrentTab);
+    m_glue->bind("_captureScreenshot", this, &Browser::captureScreenshot);
+    m_glue->bind("_dumpStatistics", this, &Browser::dumpStatistics);
     m_glue->bindToDispatcher("_reload", this, &Tab::reload);
     m_glue->bindToDispatcher("_back", this, &Tab::back);
 
@@ -176,6 +260,10 @@ void Browser::initUi()
     WKPreferencesSetWebAudioEnabled(webPreferences, true);
     WKPreferencesSetWebGLEnabled(webPreferences, true);
     WKPreferencesSetDeveloperExtrasEnabled(webPreferences, true);
+
+    // Warm processes only help when every tab gets a new one.
+    if (m_options.tabPoolSize && m_processModel.kind() == ProcessModel::ProcessPerTab)
+        m_tabPool = new TabPool(m_contentPageGroup, m_options.tabPoolSize);
 }
 
 int Browser::run()
@@ -201,7 +289,7 @@ void Browser::dispatchMessage(void (Obj::*method)())
 template<typename T>
 bool Browser::sendMouseEventToPage(T event)
 {
-    if (event->y > m_toolBarHeight && m_currentTab != -1) {
+    if (event->y > uiHeight() && m_currentTab != -1) {
         event->y -= m_toolBarHeight;
         currentTab()->sendMouseEvent(event);
         return true;
@@ -211,7 +299,15 @@ bool Browser::sendMouseEventToPage(T event)
 
 void Browser::onWindowExpose()
 {
-    scheduleUpdateDisplay();
+    scheduleFullUpdateDisplay();
+}
+
+void Browser::stampInputEvent(InputEventType type)
+{
+    // Taken, so that a stamp is never used twice.
+    gint64 time = m_inputReplayer ? m_inputReplayer->takeEventTime() : m_window->takeInputEventTime();
+    if (time && m_pendingInputs.size() < maxPendingInputs)
+        m_pendingInputs.push_back(std::make_pair(type, time));
 }
 
 void Browser::onKeyPress(NIXKeyEvent* event)
@@ -219,6 +315,14 @@ void Browser::onKeyPress(NIXKeyEvent* event)
     if (!m_uiView)
         return;
 
+    stampInputEvent(event->type == kNIXInputEventTypeKeyDown ? InputKeyPress : InputKeyRelease);
+
+    if (event->key == kNIXKeyEventKey_F12) {
+        if (event->type == kNIXInputEventTypeKeyDown)
+            toggleHud();
+        return;
+    }
+
     if (m_uiFocused)
         NIXViewSendKeyEvent(m_uiView, event);
     else if (m_currentTab != -1)
@@ -232,6 +336,7 @@ void Browser::onKeyRelease(NIXKeyEvent* event)
 
 void Browser::onMouseWheel(NIXWheelEvent* event)
 {
+    stampInputEvent(InputMouseWheel);
     sendMouseEventToPage(event);
 }
 
@@ -240,6 +345,8 @@ void Browser::onMousePress(NIXMouseEvent* event)
     if (!m_uiView)
         return;
 
+    stampInputEvent(InputMousePress);
+
     if (sendMouseEventToPage(event))
         m_uiFocused = false;
     else {
@@ -255,6 +362,7 @@ void Browser::onMousePress(NIXMouseEvent* event)
 
 void Browser::onMouseRelease(NIXMouseEvent* event)
 {
+    stampInputEvent(InputMouseRelease);
     sendMouseEventToPage(event);
 }
 
@@ -263,6 +371,8 @@ void Browser::onMouseMove(NIXMouseEvent* event)
     if (!m_uiView)
         return;
 
+    stampInputEvent(InputMouseMove);
+
     if (!sendMouseEventToPage(event))
         NIXViewSendMouseEvent(m_uiView, event);
 }
@@ -272,12 +382,14 @@ void Browser::onWindowSizeChange(WKSize size)
     if (!m_uiView)
         return;
 
-    WKViewSetSize(m_uiView, size);
+    updateUiViewSize();
 
-    // FIXME: Procrastinate this relayout on non visible tabs
+    // Only the visible tab relayouts now, hidden ones do once shown.
     WKSize contentsSize = this->contentsSize();
     for (auto p : m_tabs)
         p.second->setSize(contentsSize);
+
+    scheduleFullUpdateDisplay();
 }
 
 void Browser::onWindowClose()
@@ -285,14 +397,16 @@ void Browser::onWindowClose()
     g_main_loop_quit(m_mainLoop);
 }
 
-gboolean callUpdateDisplay(gpointer data)
+void Browser::onWindowOcclusionChange(bool occluded)
 {
-    Browser* browser = reinterpret_cast<Browser*>(data);
+    m_windowOccluded = occluded;
 
-    assert(browser->m_displayUpdateScheduled);
-    browser->m_displayUpdateScheduled = false;
-    browser->updateDisplay();
-    return 0;
+    // Nothing gets painted while nobody can see the window, and WebKit throttles the hidden tab.
+    if (m_currentTab != -1)
+        currentTab()->setVisibility(occluded ? kWKPageVisibilityStateHidden : kWKPageVisibilityStateVisible);
+
+    if (!occluded)
+        scheduleFullUpdateDisplay();
 }
 
 WKSize Browser::contentsSize() const
@@ -304,28 +418,193 @@ WKSize Browser::contentsSize() const
 
 void Browser::scheduleUpdateDisplay()
 {
-    if (m_displayUpdateScheduled)
+    ++m_displayRequests;
+    // Damage keeps accumulating meanwhile, un-occluding the window repaints everything anyway.
+    if (m_windowOccluded && m_pendingScreenshots.empty())
         return;
+    m_frameScheduler->scheduleFrame();
+}
 
-    m_displayUpdateScheduled = true;
-    g_timeout_add(0, callUpdateDisplay, this);
+void Browser::scheduleFullUpdateDisplay()
+{
+    m_needsFullRepaint = true;
+    scheduleUpdateDisplay();
 }
 
-void Browser::updateDisplay()
+bool Browser::updateDisplay()
 {
-    m_window->makeCurrent();
+    if (m_windowOccluded && m_pendingScreenshots.empty())
+        return false;
 
     WKSize size = m_window->size();
-    glViewport(0, 0, size.width, size.height);
-    glClearColor(1.0, 1.0, 1.0, 1.0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    WKRect windowRect = WKRectMake(0, 0, size.width, size.height);
+    WKRect uiRect = WKRectMake(0, 0, size.width, uiHeight());
+    WKRect contentsRect = WKRectMake(0, m_toolBarHeight, size.width, size.height - m_toolBarHeight);
+    Tab* tab = m_currentTab != -1 ? currentTab() : 0;
+    gint64 tabSwitchStart = 0;
+    bool tabRestored = false;
+
+    Damage damage;
+    if (m_needsFullRepaint)
+        damage.add(windowRect);
+    m_needsFullRepaint = false;
+
+    bool uiDirty = !m_uiDamage.isEmpty();
+    m_uiDamage.intersect(uiRect);
+    damage.add(m_uiDamage);
+    m_uiDamage.clear();
+
+    if (tab) {
+        Damage tabDamage = tab->takeDamage();
+        if (m_tabAwaitingPaint && !tabDamage.isEmpty()) {
+            // The view replaces whatever was kept on screen meanwhile.
+            m_tabAwaitingPaint = false;
+            tabDamage.add(WKRectMake(0, 0, contentsRect.size.width, contentsRect.size.height));
+            tabSwitchStart = m_tabSwitchStart;
+            m_tabSwitchStart = 0;
+            tabRestored = m_tabRestoring;
+            m_tabRestoring = false;
+            g_source_remove(m_tabPaintTimeoutSource);
+            m_tabPaintTimeoutSource = 0;
+        }
+        tabDamage.translate(0, m_toolBarHeight);
+        tabDamage.intersect(contentsRect);
+        damage.add(tabDamage);
+    }
 
-    WKViewPaintToCurrentGLContext(m_uiView);
+    damage.intersect(windowRect);
+    if (damage.isEmpty())
+        return false;
 
-    if (m_currentTab != -1)
-        WKViewPaintToCurrentGLContext(currentTab()->webView());
+    // The HUD is refreshed along with whatever else gets painted, so it costs nothing when idle.
+    if (m_hudVisible) {
+        Damage hudDamage;
+        hudDamage.add(Hud::rect(size, m_toolBarHeight));
+        hudDamage.intersect(windowRect);
+        damage.add(hudDamage);
+    }
 
-    m_window->swapBuffers();
+    CompositorFrame* frame = new CompositorFrame(m_uiView, tab ? tab->webView() : 0);
+    frame->tabId = tab ? tab->id() : -1;
+    frame->tabAwaitingPaint = m_tabAwaitingPaint;
+    frame->tabSwitchStart = tabSwitchStart;
+    frame->tabRestored = tabRestored;
+    if (m_tabAwaitingPaint && m_tabs.count(m_previousTab) && !m_tabs[m_previousTab]->isDiscarded()) {
+        frame->previousTabView = m_tabs[m_previousTab]->webView();
+        WKRetain(frame->previousTabView);
+    }
+    for (int tabId : m_hiddenTabs) {
+        std::map<int, Tab*>::iterator it = m_tabs.find(tabId);
+        if (it == m_tabs.end() || it->second == tab || it->second->isDiscarded())
+            continue;
+        WKRetain(it->second->webView());
+        frame->snapshots.push_back(std::make_pair(tabId, it->second->webView()));
+    }
+    m_hiddenTabs.clear();
+    frame->closedTabs.swap(m_closedTabs);
+    frame->discardedTabs.swap(m_discardedTabs);
+    frame->size = size;
+    frame->toolBarHeight = m_toolBarHeight;
+    frame->uiHeight = uiRect.size.height;
+    frame->damage = damage;
+    frame->uiDirty = uiDirty;
+    frame->showHud = m_hudVisible;
+    frame->displayRequests = m_displayRequests;
+    m_displayRequests = 0;
+    frame->screenshots.swap(m_pendingScreenshots);
+    frame->inputs.swap(m_pendingInputs);
+    frame->deadline = m_frameScheduler->deadline();
+    m_compositor->submitFrame(frame);
+    return true;
+}
+
+void Browser::didPresentFrame(const CompositorFrame& frame)
+{
+    m_frameScheduler->didPresentFrame(frame.deadline, frame.swapStart, frame.swapEnd);
+
+    if (frame.tabSwitchStart) {
+        gint64 latency = frame.swapEnd - frame.tabSwitchStart;
+        ++m_tabSwitches;
+        m_tabSwitchLatencyTotal += latency;
+        m_tabSwitchLatencyMax = std::max(m_tabSwitchLatencyMax, latency);
+        if (frame.tabRestored) {
+            ++m_tabRestoresPainted;
+            m_tabRestoreLatencyTotal += latency;
+            m_tabRestoreLatencyMax = std::max(m_tabRestoreLatencyMax, latency);
+        }
+    }
+
+    // Input with no visible effect would be measured against whatever frame came next.
+    gint64 maxLatency = maxInputLatencyFrames * m_frameScheduler->refreshInterval();
+    for (const std::pair<InputEventType, gint64>& input : frame.inputs) {
+        gint64 latency = frame.swapEnd - input.second;
+        if (latency <= maxLatency)
+            m_inputLatency.addSample(input.first, latency);
+        else
+            m_inputLatency.dropStaleSample(input.first);
+    }
+}
+
+void Browser::captureScreenshot(const std::string& fileName)
+{
+    if (fileName.empty())
+        return;
+
+    m_pendingScreenshots.push_back(fileName);
+    scheduleFullUpdateDisplay();
+}
+
+void Browser::didSaveScreenshot(const std::string& fileName, bool saved)
+{
+    if (saved)
+        std::cout << "Screenshot saved to " << fileName << std::endl;
+
+    if (m_screenshotRequested && fileName == m_options.screenshot)
+        onWindowClose();
+}
+
+void Browser::didFinishReplay()
+{
+    dumpStatistics();
+    onWindowClose();
+}
+
+void Browser::tabLoadFinished(Tab* tab)
+{
+    m_loadScheduler.didFinishLoad(tab);
+
+    // Replayed events land where they were recorded only once the page is there.
+    if (m_inputReplayer && m_currentTab != -1 && tab == currentTab())
+        m_inputReplayer->start();
+
+    if (m_options.screenshot.empty() || m_screenshotRequested || m_currentTab == -1 || tab != currentTab())
+        return;
+
+    m_screenshotRequested = true;
+    captureScreenshot(m_options.screenshot);
+}
+
+void Browser::toggleHud()
+{
+    m_hudVisible = !m_hudVisible;
+    scheduleFullUpdateDisplay();
+}
+
+void Browser::updateUiViewSize()
+{
+    // Once the tool bar height is known the UI view only covers it, and an open popup, so
+    // repainting the chrome doesn't overwrite the tab contents below it.
+    WKSize size = m_window->size();
+    size.height = uiHeight();
+    WKViewSetSize(m_uiView, size);
+}
+
+int Browser::uiHeight() const
+{
+    int windowHeight = m_window->size().height;
+    if (!m_toolBarHeight)
+        return windowHeight;
+    return std::min(m_toolBarHeight + m_popupHeight, windowHeight);
 }
 
 Tab* Browser::currentTab()
@@ -335,18 +614,32 @@ Tab* Browser::currentTab()
 
 void Browser::didUiReady()
 {
-    if (m_initialUrls.empty())
+    if (m_options.urls.empty())
         requestTab();
     else {
         m_uiFocused = false;
-        for (const std::string& url : m_initialUrls)
-            requestTab()->loadUrl(url);
+        for (const std::string& url : m_options.urls)
+            m_loadScheduler.enqueue(requestTab(0, url), url);
     }
+
+    // Warming up before the first tabs are created would only delay them.
+    if (m_tabPool)
+        m_tabPool->scheduleRefill();
 }
 
-Tab* Browser::requestTab(Tab* parent)
+Tab* Browser::requestTab(Tab* parent, const std::string& url)
 {
-    Tab* tab = parent ? new Tab(parent) : new Tab(this);
+    Tab* tab = 0;
+    WKContextRef context;
+    WKViewRef view;
+    if (parent)
+        tab = new Tab(parent);
+    else if (m_tabPool && m_tabPool->take(context, view)) {
+        tab = new Tab(this, context, view);
+        m_tabPool->scheduleRefill();
+    } else
+        tab = new Tab(this, m_processModel.contextForUrl(url));
+    m_processModel.didOpenTab(tab->context());
     tab->setViewportTranslation(0, m_toolBarHeight);
     m_tabs[tab->id()] = tab;
     tab->setSize(contentsSize());
@@ -361,7 +654,13 @@ void Browser::closeTab(const int& tabId)
     Tab* tab = m_tabs[tabId];
     m_tabs.erase(tabId);
     m_currentTab = -1;
+    m_closedTabs.push_back(tabId);
+    if (tabId == m_previousTab)
+        m_previousTab = -1;
+    m_processModel.didCloseTab(tab->context());
+    m_loadScheduler.didCloseTab(tab);
     delete tab;
+    scheduleFullUpdateDisplay();
     if (m_tabs.empty())
         onWindowClose();
 }
@@ -369,14 +668,28 @@ void Browser::closeTab(const int& tabId)
 void Browser::toolBarHeightChanged(const int& height)
 {
     m_toolBarHeight = height;
+    updateUiViewSize();
 
-    // FIXME: Better to delay this global relayout in a near future
+    // Only the visible tab relayouts now, hidden ones do once shown.
     WKSize contentsSize = this->contentsSize();
     for (auto p : m_tabs) {
         Tab* tab = p.second;
         tab->setViewportTranslation(0, m_toolBarHeight);
         tab->setSize(contentsSize);
     }
+
+    scheduleFullUpdateDisplay();
+}
+
+void Browser::popupHeightChanged(const int& height)
+{
+    if (height == m_popupHeight)
+        return;
+
+    // The area the popup covered, or is about to, gets repainted from the tab too.
+    m_popupHeight = std::max(height, 0);
+    updateUiViewSize();
+    scheduleFullUpdateDisplay();
 }
 
 void Browser::setCurrentTab(const int& tabId)
@@ -384,18 +697,119 @@ void Browser::setCurrentTab(const int& tabId)
     if (!m_tabs.count(tabId))
         return;
 
-    if (m_currentTab != -1)
-        currentTab()->setVisibility(kWKPageVisibilityStateHidden);
+    if (m_currentTab != tabId) {
+        if (m_currentTab != -1) {
+            currentTab()->setVisibility(kWKPageVisibilityStateHidden);
+            m_hiddenTabs.push_back(m_currentTab);
+        }
+        // Unless it never got painted, the tab being left is what's on screen.
+        if (!m_tabAwaitingPaint)
+            m_previousTab = m_currentTab;
+
+        m_tabSwitchStart = g_get_monotonic_time();
+        Tab* tab = m_tabs[tabId];
+        m_tabRestoring = tab->isDiscarded();
+        if (m_tabRestoring) {
+            tab->restore();
+            m_loadScheduler.didRestoreTab(tab);
+            ++m_tabRestores;
+        }
+
+        // Damage gathered while hidden is stale, the next paint request tells the view is ready.
+        tab->takeDamage();
+        m_tabAwaitingPaint = true;
+        if (m_tabPaintTimeoutSource)
+            g_source_remove(m_tabPaintTimeoutSource);
+        guint timeout = m_tabRestoring ? restoredTabPaintTimeout : tabPaintTimeout;
+        m_tabPaintTimeoutSource = scheduleTimeout(PaintClass, timeout, [](gpointer data) -> gboolean {
+            reinterpret_cast<Browser*>(data)->tabPaintTimedOut();
+            return false;
+        }, this);
+    }
 
     m_currentTab = tabId;
 
+    // Applies the size and viewport translation changes queued while hidden.
     Tab* tab = currentTab();
-    WKViewSetSize(tab->webView(), contentsSize());
-    tab->setVisibility(kWKPageVisibilityStateVisible);
+    tab->setVisibility(m_windowOccluded ? kWKPageVisibilityStateHidden : kWKPageVisibilityStateVisible);
+    m_loadScheduler.tabShown(tab);
+    scheduleFullUpdateDisplay();
+}
+
+void Browser::tabPaintTimedOut()
+{
+    // Stop waiting for a view that doesn't need to repaint after all.
+    m_tabPaintTimeoutSource = 0;
+    m_tabAwaitingPaint = false;
+    m_tabSwitchStart = 0;
+    m_tabRestoring = false;
+    ++m_tabSwitchTimeouts;
+    scheduleFullUpdateDisplay();
+}
+
+void Browser::discardHiddenTabs()
+{
+    gint64 hiddenBefore = g_get_monotonic_time() - gint64(m_options.discardAfter) * G_USEC_PER_SEC;
+    size_t liveTabs = 0;
+    std::vector<Tab*> candidates;
+    for (auto p : m_tabs) {
+        Tab* tab = p.second;
+        if (tab->isDiscarded())
+            continue;
+        ++liveTabs;
+        // The previous tab may still be on screen while the current one waits for its first paint.
+        if (p.first == m_currentTab || (m_tabAwaitingPaint && p.first == m_previousTab))
+            continue;
+        // The scheduler would load into a closed page.
+        if (m_loadScheduler.hasPendingLoad(tab))
+            continue;
+        if (tab->lastVisibilityChange() <= hiddenBefore)
+            candidates.push_back(tab);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](Tab* a, Tab* b) {
+        return a->lastVisibilityChange() < b->lastVisibilityChange();
+    });
+    for (Tab* tab : candidates) {
+        if (liveTabs <= m_options.liveTabs)
+            break;
+        // The compositor keeps its thumbnail aside, and the UI keeps showing the tab.
+        tab->discard();
+        m_discardedTabs.push_back(tab->id());
+        --liveTabs;
+        ++m_tabDiscards;
+    }
+}
+
+void Browser::dumpStatistics()
+{
+    std::cerr << "Drowser statistics:" << std::endl;
+    m_frameScheduler->dumpStatistics(std::cerr);
+    m_compositor->dumpStatistics(std::cerr);
+    m_window->dumpStatistics(std::cerr);
+    std::cerr << "Tab switches: " << m_tabSwitches << " painted";
+    if (m_tabSwitches) {
+        std::cerr << ", latency " << m_tabSwitchLatencyTotal / m_tabSwitches / 1000.0 << "ms on average, "
+            << m_tabSwitchLatencyMax / 1000.0 << "ms max";
+    }
+    std::cerr << ", " << m_tabSwitchTimeouts << " timed out" << std::endl;
+    std::cerr << "Tabs discarded: " << m_tabDiscards << ", restored: " << m_tabRestores;
+    if (m_tabRestoresPainted) {
+        std::cerr << ", restore latency " << m_tabRestoreLatencyTotal / m_tabRestoresPainted / 1000.0 << "ms on average, "
+            << m_tabRestoreLatencyMax / 1000.0 << "ms max";
+    }
+    std::cerr << std::endl;
+    if (m_tabPool)
+        m_tabPool->dumpStatistics(std::cerr);
+    m_processModel.dumpStatistics(std::cerr);
+    m_loadScheduler.dumpStatistics(std::cerr);
+    m_inputLatency.dumpStatistics(std::cerr);
+    dumpSchedulingStatistics(std::cerr);
 }
 
 void Browser::loadUrlOnCurrentTab(const std::string& url)
 {
     m_uiFocused = false;
+    m_processModel.didLoadUrl(currentTab()->context(), url);
     currentTab()->loadUrl(url);
 }
@@ -26,7 +26,14 @@
 #ifndef Browser_h
 #define Browser_h
 
+#include "Compositor.h"
+#include "Damage.h"
 #include "DesktopWindow.h"
+#include "FrameScheduler.h"
+#include "InputLatency.h"
+#include "InputReplayer.h"
+#include "LoadScheduler.h"
+#include "ProcessModel.h"
 #include <glib.h>
 #include <NIXView.h>
 #include <map>
@@ -37,16 +44,48 @@ class Tab;
 
 std::string getApplicationPath();
 
-extern "C" {
-gboolean callUpdateDisplay(gpointer);
-}
-
 class InjectedBundleGlue;
 
-class Browser : public DesktopWindowClient
+struct BrowserOptions {
+    BrowserOptions() : threadedCompositor(false), headless(false), showHud(false), presentation(AutomaticPresentation), swapInterval(-1), replayPaced(true), processModel(ProcessModel::ProcessPerTab), maxProcesses(8), tabPoolSize(1), liveTabs(8), discardAfter(60), maxConcurrentLoads(3) {}
+
+    std::vector<std::string> urls;
+    // Experimental: nothing keeps WebKit from changing a view's scene while it's being painted.
+    bool threadedCompositor;
+    bool headless;
+    // Shown from startup, F12 toggles it anyway.
+    bool showHud;
+    PresentationMode presentation;
+    // Left to the driver when negative.
+    int swapInterval;
+    // Saved once the current tab finishes loading, quitting afterwards.
+    std::string screenshot;
+    // Every presented frame is recorded there, as WebM or MP4 depending on the extension.
+    std::string recordVideo;
+    // Input events are logged there, or replayed from there once the first tab is loaded.
+    std::string recordInput;
+    std::string replayInput;
+    bool replayPaced;
+    ProcessModel::Kind processModel;
+    // Only limits the processes of the per site model.
+    unsigned maxProcesses;
+    // Web processes kept warm for new tabs, when each tab has its own.
+    unsigned tabPoolSize;
+    // Tabs hidden for more than discardAfter seconds are discarded, longest hidden first, while more
+    // than liveTabs keep their page. Never discarded when liveTabs is 0.
+    unsigned liveTabs;
+    unsigned discardAfter;
+    // Loads of the URLs given at startup running at once, besides the visible tab.
+    unsigned maxConcurrentLoads;
+};
+
+class InputRecorder;
+class TabPool;
+
+class Browser : public DesktopWindowClient, public FrameScheduler::Client, public Compositor::Client, public InputReplayer::Client
 {
 public:
-    Browser(const std::vector<std::string>& urls);
+    Browser(const BrowserOptions&);
     ~Browser();
 
     int run();
@@ -61,15 +100,31 @@ public:
     virtual void onMouseWheel(NIXWheelEvent*);
     virtual void onWindowSizeChange(WKSize);
     virtual void onWindowClose();
+    virtual void onWindowOcclusionChange(bool occluded);
+
+    // FrameScheduler::Client
+    virtual bool updateDisplay();
+
+    // Compositor::Client
+    virtual void didPresentFrame(const CompositorFrame&);
+    virtual void didSaveScreenshot(const std::string& fileName, bool saved);
+
+    // InputReplayer::Client
+    virtual void didFinishReplay();
 
     void didUiReady();
-    Tab* requestTab(Tab* parent);
+    // The URL the tab is about to load, if known, decides its web process in the per site model.
+    Tab* requestTab(Tab* parent, const std::string& url = std::string());
     Tab* requestTab() { return requestTab(0); }
     void closeTab(const int& tabId);
     void toolBarHeightChanged(const int& height);
+    // How far an open popup of the UI, like a completion list or a menu, reaches below the tool bar.
+    void popupHeightChanged(const int& height);
     void setCurrentTab(const int& tabId);
     void loadUrlOnCurrentTab(const std::string& url);
     Tab* currentTab();
+    void tabLoadFinished(Tab*);
+    void captureScreenshot(const std::string& fileName);
 
     template<typename Param, typename Obj>
     void dispatchMessage(const Param& param, void (Obj::*method)(const Param&));
@@ -85,10 +140,48 @@ public:
 
     DesktopWindow* window() { return m_window; }
 
+    void dumpStatistics();
+
 private:
+    void stampInputEvent(InputEventType);
+
     GMainLoop* m_mainLoop;
-    bool m_displayUpdateScheduled;
+    bool m_needsFullRepaint;
+    bool m_windowOccluded;
+    bool m_hudVisible;
+    unsigned m_displayRequests;
+    std::vector<std::string> m_pendingScreenshots;
+    bool m_screenshotRequested;
+    // Tabs hidden or closed since the last frame, for the thumbnail atlas.
+    std::vector<int> m_hiddenTabs;
+    std::vector<int> m_closedTabs;
+    std::vector<int> m_discardedTabs;
+    // The current tab shows its thumbnail, or the previous tab is kept, until it asks for its first paint.
+    bool m_tabAwaitingPaint;
+    int m_previousTab;
+    gint64 m_tabSwitchStart;
+    guint m_tabPaintTimeoutSource;
+    unsigned m_tabSwitches;
+    unsigned m_tabSwitchTimeouts;
+    gint64 m_tabSwitchLatencyTotal;
+    gint64 m_tabSwitchLatencyMax;
+    // The tab switched to was restored from its session state and hasn't been painted yet.
+    bool m_tabRestoring;
+    guint m_discardSource;
+    unsigned m_tabDiscards;
+    unsigned m_tabRestores;
+    unsigned m_tabRestoresPainted;
+    gint64 m_tabRestoreLatencyTotal;
+    gint64 m_tabRestoreLatencyMax;
+    // Inputs waiting for the next frame, which presents their effects if they have any.
+    std::vector<std::pair<InputEventType, gint64> > m_pendingInputs;
+    InputLatency m_inputLatency;
+    Damage m_uiDamage;
     DesktopWindow* m_window;
+    InputRecorder* m_inputRecorder;
+    InputReplayer* m_inputReplayer;
+    FrameScheduler* m_frameScheduler;
+    Compositor* m_compositor;
     InjectedBundleGlue* m_glue;
 
     WKViewRef m_uiView;
@@ -98,20 +191,27 @@ private:
 
     bool m_uiFocused;
     int m_toolBarHeight;
+    int m_popupHeight;
 
     std::map<int, Tab*> m_tabs;
+    TabPool* m_tabPool;
+    ProcessModel m_processModel;
+    LoadScheduler m_loadScheduler;
     int m_currentTab;
     WKPageGroupRef m_contentPageGroup;
 
-    const std::vector<std::string>& m_initialUrls;
+    BrowserOptions m_options;
 
     template<typename T>
     bool sendMouseEventToPage(T event);
 
-    void updateDisplay();
+    void scheduleFullUpdateDisplay();
+    void toggleHud();
+    void tabPaintTimedOut();
+    void discardHiddenTabs();
+    void updateUiViewSize();
+    int uiHeight() const;
     void initUi();
-
-    friend gboolean callUpdateDisplay(gpointer);
 };
 
 #endif
@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Compositor.h"
+
+#include "DesktopWindow.h"
+#include "GLFramebuffer.h"
+#include "Hud.h"
+#include "MainLoopScheduling.h"
+#include "VideoRecorder.h"
+#include <cassert>
+#include <cerrno>
+
+// Back buffers older than this are repainted entirely.
+static const size_t maxTrackedBufferAge = 4;
+
+static const size_t thumbnailAtlasMemoryCap = 8 * 1024 * 1024;
+
+// How often readbacks still in flight are polled when no frame comes to collect them.
+static const unsigned readbackPollInterval = 8;
+
+CompositorFrame::CompositorFrame(WKViewRef uiView, WKViewRef tabView)
+    : uiView(uiView)
+    , tabView(tabView)
+    , tabId(-1)
+    , size(WKSizeMake(0, 0))
+    , toolBarHeight(0)
+    , uiHeight(0)
+    , uiDirty(false)
+    , showHud(false)
+    , deadline(0)
+    , displayRequests(0)
+    , tabAwaitingPaint(false)
+    , previousTabView(0)
+    , tabSwitchStart(0)
+    , tabRestored(false)
+    , uiPaintTime(0)
+    , tabPaintTime(0)
+    , swapStart(0)
+    , swapEnd(0)
+{
+    WKRetain(uiView);
+    if (tabView)
+        WKRetain(tabView);
+}
+
+CompositorFrame::~CompositorFrame()
+{
+    WKRelease(uiView);
+    if (tabView)
+        WKRelease(tabView);
+    if (previousTabView)
+        WKRelease(previousTabView);
+    for (const std::pair<int, WKViewRef>& snapshot : snapshots)
+        WKRelease(snapshot.second);
+}
+
+void CompositorFrame::merge(const CompositorFrame& other)
+{
+    damage.add(other.damage);
+    uiDirty |= other.uiDirty;
+    if (!tabSwitchStart) {
+        tabSwitchStart = other.tabSwitchStart;
+        tabRestored = other.tabRestored;
+    }
+    displayRequests += other.displayRequests;
+    screenshots.insert(screenshots.begin(), other.screenshots.begin(), other.screenshots.end());
+    for (const std::pair<int, WKViewRef>& snapshot : other.snapshots)
+        WKRetain(snapshot.second);
+    snapshots.insert(snapshots.begin(), other.snapshots.begin(), other.snapshots.end());
+    closedTabs.insert(closedTabs.end(), other.closedTabs.begin(), other.closedTabs.end());
+    discardedTabs.insert(discardedTabs.begin(), other.discardedTabs.begin(), other.discardedTabs.end());
+    inputs.insert(inputs.begin(), other.inputs.begin(), other.inputs.end());
+}
+
+struct PresentedFrameSource {
+    GSource source;
+    Compositor* compositor;
+
+    void dispatch() { compositor->deliverPresentedFrames(); }
+};
+
+static gboolean presentedFrameSourceDispatch(GSource* source, GSourceFunc, gpointer)
+{
+    gint64 start = g_get_monotonic_time();
+    g_source_set_ready_time(source, -1);
+    reinterpret_cast<PresentedFrameSource*>(source)->dispatch();
+    accountDispatch(PaintClass, start);
+    return true;
+}
+
+static GSourceFuncs presentedFrameSourceFuncs = {
+    0,
+    0,
+    presentedFrameSourceDispatch,
+    0
+};
+
+Compositor::Compositor(DesktopWindow* window, Client* client, bool threaded, const std::string& videoFileName)
+    : m_window(window)
+    , m_client(client)
+    , m_uiCache(0)
+    , m_uiCacheDirty(true)
+    , m_hud(new Hud)
+    , m_screenshots(client)
+    , m_thumbnails(thumbnailAtlasMemoryCap)
+    , m_recorder(videoFileName.empty() ? 0 : new VideoRecorder(videoFileName))
+    , m_collectReadbacksSource(0)
+    , m_thread(0)
+    , m_quit(false)
+    , m_pendingFrame(0)
+    , m_presentedFrames(0)
+    , m_presentedSource(0)
+    , m_framesSubmitted(0)
+    , m_framesMerged(0)
+    , m_framesPainted(0)
+    , m_paintTime(0)
+    , m_presentTime(0)
+{
+    assert(window);
+    assert(client);
+
+    sem_init(&m_wakeUp, 0, 0);
+    if (!threaded)
+        return;
+
+    m_presentedFrames = g_async_queue_new();
+    m_presentedSource = g_source_new(&presentedFrameSourceFuncs, sizeof(PresentedFrameSource));
+    reinterpret_cast<PresentedFrameSource*>(m_presentedSource)->compositor = this;
+    // Frame timing feeds on presented frames, they're as urgent as painting.
+    g_source_set_priority(m_presentedSource, schedulingPriority(PaintClass));
+    g_source_attach(m_presentedSource, 0);
+
+    // The GL context can only be current in one thread at a time.
+    m_window->doneCurrent();
+    m_thread = g_thread_new("Compositor", threadMain, this);
+}
+
+Compositor::~Compositor()
+{
+    if (m_thread) {
+        m_quit = true;
+        sem_post(&m_wakeUp);
+        g_thread_join(m_thread);
+
+        delete m_pendingFrame.exchange(0);
+        while (CompositorFrame* frame = reinterpret_cast<CompositorFrame*>(g_async_queue_try_pop(m_presentedFrames)))
+            delete frame;
+        g_async_queue_unref(m_presentedFrames);
+        g_source_destroy(m_presentedSource);
+        g_source_unref(m_presentedSource);
+
+        m_window->makeCurrent();
+    } else {
+        if (m_collectReadbacksSource)
+            g_source_remove(m_collectReadbacksSource);
+        m_window->makeCurrent();
+        releaseGLResources();
+    }
+
+    delete m_hud;
+    delete m_recorder;
+    sem_destroy(&m_wakeUp);
+}
+
+void Compositor::submitFrame(CompositorFrame* frame)
+{
+    ++m_framesSubmitted;
+
+    if (!m_thread) {
+        paintFrame(*frame);
+        m_client->didPresentFrame(*frame);
+        delete frame;
+
+        if (hasPendingReadbacks() && !m_collectReadbacksSource) {
+            m_collectReadbacksSource = scheduleTimeout(BookkeepingClass, readbackPollInterval, [](gpointer data) -> gboolean {
+                Compositor* self = reinterpret_cast<Compositor*>(data);
+                self->m_window->makeCurrent();
+                self->collectReadbacks(false);
+                if (self->hasPendingReadbacks())
+                    return true;
+                self->m_collectReadbacksSource = 0;
+                return false;
+            }, this);
+        }
+        return;
+    }
+
+    if (CompositorFrame* unpainted = m_pendingFrame.exchange(0)) {
+        frame->merge(*unpainted);
+        delete unpainted;
+        ++m_framesMerged;
+    }
+
+    m_pendingFrame.store(frame);
+    sem_post(&m_wakeUp);
+}
+
+gpointer Compositor::threadMain(gpointer data)
+{
+    Compositor* self = reinterpret_cast<Compositor*>(data);
+    self->m_window->makeCurrent();
+
+    while (true) {
+        // Readbacks in flight must be collected even if no other frame comes.
+        if (self->hasPendingReadbacks()) {
+            gint64 timeout = g_get_real_time() + readbackPollInterval * 1000;
+            struct timespec deadline = { timeout / G_USEC_PER_SEC, (timeout % G_USEC_PER_SEC) * 1000 };
+            if (sem_timedwait(&self->m_wakeUp, &deadline)) {
+                if (errno == ETIMEDOUT)
+                    self->collectReadbacks(false);
+                continue;
+            }
+        } else if (sem_wait(&self->m_wakeUp) && errno == EINTR)
+            continue;
+        if (self->m_quit)
+            break;
+
+        CompositorFrame* frame = self->m_pendingFrame.exchange(0);
+        if (!frame)
+            continue;
+
+        self->paintFrame(*frame);
+        g_async_queue_push(self->m_presentedFrames, frame);
+        g_source_set_ready_time(self->m_presentedSource, 0);
+    }
+
+    self->releaseGLResources();
+    self->m_window->doneCurrent();
+    return 0;
+}
+
+void Compositor::deliverPresentedFrames()
+{
+    while (CompositorFrame* frame = reinterpret_cast<CompositorFrame*>(g_async_queue_try_pop(m_presentedFrames))) {
+        m_client->didPresentFrame(*frame);
+        delete frame;
+    }
+}
+
+void Compositor::paintFrame(CompositorFrame& frame)
+{
+    const WKSize& size = frame.size;
+    WKRect windowRect = WKRectMake(0, 0, size.width, size.height);
+    WKRect uiRect = WKRectMake(0, 0, size.width, frame.uiHeight);
+    WKRect contentsRect = WKRectMake(0, frame.toolBarHeight, size.width, size.height - frame.toolBarHeight);
+
+    m_window->makeCurrent();
+    m_window->beginFrame(size);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_window->framebuffer());
+    collectReadbacks(false);
+    gint64 paintStart = g_get_monotonic_time();
+
+    for (int tabId : frame.closedTabs)
+        m_thumbnails.remove(tabId);
+    if (!frame.snapshots.empty()) {
+        takeSnapshots(frame, contentsRect);
+        // The window framebuffer was painted over.
+        frame.damage.add(windowRect);
+    }
+    for (int tabId : frame.discardedTabs)
+        m_thumbnails.keep(tabId, m_window->framebuffer());
+
+    // The back buffer still holds the frame presented bufferAge() frames ago, so whatever was
+    // damaged since then has to be painted again.
+    Damage repaint = frame.damage;
+    size_t bufferAge = m_window->bufferAge();
+    if (!bufferAge || bufferAge > m_damageHistory.size() + 1)
+        repaint.add(windowRect);
+    else {
+        for (size_t i = 0; i < bufferAge - 1; ++i)
+            repaint.add(m_damageHistory[i]);
+    }
+
+    m_damageHistory.push_front(frame.damage);
+    if (m_damageHistory.size() > maxTrackedBufferAge)
+        m_damageHistory.pop_back();
+
+    const WKRect& repaintRect = repaint.bounds();
+    glViewport(0, 0, size.width, size.height);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(repaintRect.origin.x, size.height - repaintRect.origin.y - repaintRect.size.height, repaintRect.size.width, repaintRect.size.height);
+    glClearColor(1.0, 1.0, 1.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+
+    // TextureMapper resets the scissor box to the viewport when it starts painting, so a view is
+    // always painted whole. Views outside the damaged area are skipped instead. The UI goes last,
+    // an open popup of it hangs over the tab.
+    gint64 tabPaintStart = g_get_monotonic_time();
+    if (frame.tabView && repaint.intersects(contentsRect)) {
+        if (!frame.tabAwaitingPaint)
+            WKViewPaintToCurrentGLContext(frame.tabView);
+        else if (!m_thumbnails.draw(frame.tabId, m_window->framebuffer(), contentsRect, size.height))
+            WKViewPaintToCurrentGLContext(frame.previousTabView ? frame.previousTabView : frame.tabView);
+    }
+
+    gint64 uiPaintStart = g_get_monotonic_time();
+    frame.tabPaintTime = uiPaintStart - tabPaintStart;
+    if (frame.uiDirty)
+        m_uiCacheDirty = true;
+    if (repaint.intersects(uiRect)) {
+        if (updateUiCache(frame, uiRect.size)) {
+            Damage uiRepaint = repaint;
+            uiRepaint.intersect(uiRect);
+            m_uiCache->blitTo(m_window->framebuffer(), uiRepaint.bounds(), size.height);
+        } else
+            WKViewPaintToCurrentGLContext(frame.uiView);
+    }
+    frame.uiPaintTime = g_get_monotonic_time() - uiPaintStart;
+
+    for (const std::string& fileName : frame.screenshots)
+        m_screenshots.capture(m_window->framebuffer(), size, fileName);
+    if (m_recorder)
+        m_recorder->recordFrame(m_window->framebuffer(), size);
+
+    if (frame.showHud)
+        m_hud->paint(m_window->framebuffer(), Hud::rect(size, frame.toolBarHeight).origin, size.height);
+
+    frame.swapStart = g_get_monotonic_time();
+    m_window->swapBuffers(frame.damage.bounds());
+    frame.swapEnd = g_get_monotonic_time();
+    m_hud->recordFrame(frame);
+
+    ++m_framesPainted;
+    m_paintTime += frame.swapStart - paintStart;
+    m_presentTime += frame.swapEnd - frame.swapStart;
+}
+
+bool Compositor::updateUiCache(CompositorFrame& frame, const WKSize& size)
+{
+    // The chrome changes far less often than page contents, so it's painted into a texture only
+    // when the UI view asks for it and just copied to the window on the other frames.
+    if (!m_uiCache)
+        m_uiCache = new GLFramebuffer;
+
+    if (m_uiCache->resize(size))
+        m_uiCacheDirty = true;
+
+    if (!m_uiCache->isComplete())
+        return false;
+
+    if (!m_uiCacheDirty)
+        return true;
+
+    m_uiCache->bind();
+    glClearColor(1.0, 1.0, 1.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    WKViewPaintToCurrentGLContext(frame.uiView);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_window->framebuffer());
+    glViewport(0, 0, frame.size.width, frame.size.height);
+    m_uiCacheDirty = false;
+    return true;
+}
+
+void Compositor::takeSnapshots(CompositorFrame& frame, const WKRect& contentsRect)
+{
+    // The hidden views still have their layers, they're painted one last time in the window
+    // framebuffer, which the frame repaints entirely afterwards, and scaled down into the atlas.
+    glViewport(0, 0, frame.size.width, frame.size.height);
+    glClearColor(1.0, 1.0, 1.0, 1.0);
+    for (const std::pair<int, WKViewRef>& snapshot : frame.snapshots) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        WKViewPaintToCurrentGLContext(snapshot.second);
+        m_thumbnails.store(snapshot.first, m_window->framebuffer(), contentsRect, frame.size.height);
+    }
+}
+
+bool Compositor::hasPendingReadbacks() const
+{
+    return m_screenshots.hasPendingReadbacks() || (m_recorder && m_recorder->hasPendingReadbacks());
+}
+
+void Compositor::collectReadbacks(bool wait)
+{
+    m_screenshots.collect(wait);
+    if (m_recorder)
+        m_recorder->collect(wait);
+}
+
+void Compositor::releaseGLResources()
+{
+    delete m_uiCache;
+    m_uiCache = 0;
+    m_hud->releaseGLResources();
+    m_screenshots.releaseGLResources();
+    if (m_recorder)
+        m_recorder->releaseGLResources();
+    m_thumbnails.releaseGLResources();
+}
+
+void Compositor::dumpStatistics(std::ostream& out) const
+{
+    out << "Compositor: " << (m_thread ? "threaded, " : "main thread, ")
+        << m_framesSubmitted << " frames submitted, "
+        << m_framesMerged << " merged before painting" << std::endl;
+    if (m_framesPainted) {
+        out << "Frame time: " << m_paintTime / m_framesPainted << "us paint, "
+            << m_presentTime / m_framesPainted << "us present ("
+            << m_window->presentationMethod() << ") on average over "
+            << m_framesPainted << " frames" << std::endl;
+    }
+    out << "Thumbnails: " << m_thumbnails.size() << " of " << m_thumbnails.capacity() << " slots used, "
+        << m_thumbnails.evictions() << " evicted, " << m_thumbnails.kept() << " kept for discarded tabs" << std::endl;
+    if (m_recorder)
+        m_recorder->dumpStatistics(out);
+}
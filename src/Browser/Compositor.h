@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef Compositor_h
+#define Compositor_h
+
+#include "Damage.h"
+#include "InputLatency.h"
+#include "ScreenshotCapturer.h"
+#include "ThumbnailAtlas.h"
+#include <NIXView.h>
+#include <atomic>
+#include <deque>
+#include <glib.h>
+#include <ostream>
+#include <semaphore.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+class DesktopWindow;
+class GLFramebuffer;
+class Hud;
+class VideoRecorder;
+struct PresentedFrameSource;
+
+// Everything the compositor needs to paint a frame. Created and destroyed on the main thread,
+// which is the only one allowed to touch the reference counts of the views.
+struct CompositorFrame {
+    CompositorFrame(WKViewRef uiView, WKViewRef tabView);
+    ~CompositorFrame();
+
+    // Folds a frame that was never painted into this one.
+    void merge(const CompositorFrame&);
+
+    WKViewRef uiView;
+    WKViewRef tabView;
+    int tabId;
+    WKSize size;
+    int toolBarHeight;
+    // The UI view covers the tool bar and whatever popup of it is open below, and is painted over the tab.
+    int uiHeight;
+    Damage damage;
+    bool uiDirty;
+    bool showHud;
+    gint64 deadline;
+    // Display requests from the views since the previous frame.
+    unsigned displayRequests;
+    // Files to save this frame to, once painted.
+    std::vector<std::string> screenshots;
+    // The tab was just switched to and its view has nothing to paint yet, so its thumbnail is
+    // shown instead or, lacking one, the previous tab is kept on screen. The view is retained.
+    bool tabAwaitingPaint;
+    WKViewRef previousTabView;
+    // Set on the first frame painting the view of a tab switched to.
+    gint64 tabSwitchStart;
+    // Along with it, when the tab had been discarded and its page restored.
+    bool tabRestored;
+    // Tabs just hidden, whose views are painted into the thumbnail atlas first. The views are retained.
+    std::vector<std::pair<int, WKViewRef> > snapshots;
+    std::vector<int> closedTabs;
+    // Tabs just discarded, whose thumbnails can't be refreshed anymore and are kept aside until the
+    // tabs are hidden again or closed.
+    std::vector<int> discardedTabs;
+    // Input events handled since the previous frame, with the time they were received.
+    std::vector<std::pair<InputEventType, gint64> > inputs;
+
+    // Filled in by the compositor.
+    gint64 uiPaintTime;
+    gint64 tabPaintTime;
+    gint64 swapStart;
+    gint64 swapEnd;
+
+private:
+    CompositorFrame(const CompositorFrame&) = delete;
+    CompositorFrame& operator=(const CompositorFrame&) = delete;
+};
+
+// Paints and presents frames prepared by the Browser. When threaded, the compositor thread owns the
+// GL context and frames are handed to it through a single lock-free slot: a frame submitted before
+// the previous one was picked up replaces it, so the main thread never waits on painting or swaps.
+class Compositor {
+public:
+    class Client : public ScreenshotCapturer::Client {
+    public:
+        // Called on the main thread after a submitted frame was presented.
+        virtual void didPresentFrame(const CompositorFrame&) = 0;
+    };
+
+    // Every presented frame is recorded to videoFileName, unless empty.
+    Compositor(DesktopWindow*, Client*, bool threaded, const std::string& videoFileName);
+    ~Compositor();
+
+    bool isThreaded() const { return m_thread; }
+
+    // Takes ownership of the frame.
+    void submitFrame(CompositorFrame*);
+
+    void dumpStatistics(std::ostream&) const;
+
+private:
+    friend struct PresentedFrameSource;
+
+    static gpointer threadMain(gpointer);
+    void deliverPresentedFrames();
+    void paintFrame(CompositorFrame&);
+    bool updateUiCache(CompositorFrame&, const WKSize&);
+    void takeSnapshots(CompositorFrame&, const WKRect& contentsRect);
+    bool hasPendingReadbacks() const;
+    void collectReadbacks(bool wait);
+    void releaseGLResources();
+
+    DesktopWindow* m_window;
+    Client* m_client;
+
+    // Only touched by the thread owning the GL context.
+    GLFramebuffer* m_uiCache;
+    bool m_uiCacheDirty;
+    std::deque<Damage> m_damageHistory;
+    Hud* m_hud;
+    ScreenshotCapturer m_screenshots;
+    ThumbnailAtlas m_thumbnails;
+    VideoRecorder* m_recorder;
+    guint m_collectReadbacksSource;
+
+    GThread* m_thread;
+    sem_t m_wakeUp;
+    std::atomic<bool> m_quit;
+    std::atomic<CompositorFrame*> m_pendingFrame;
+    GAsyncQueue* m_presentedFrames;
+    GSource* m_presentedSource;
+
+    unsigned m_framesSubmitted;
+    unsigned m_framesMerged;
+
+    // Owned by the painting thread, only read racily for statistics.
+    unsigned m_framesPainted;
+    gint64 m_paintTime;
+    gint64 m_presentTime;
+};
+
+#endif
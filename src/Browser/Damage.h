@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef Damage_h
+#define Damage_h
+
+#include <WebKit2/WKGeometry.h>
+#include <algorithm>
+#include <cmath>
+
+// Accumulates damaged areas of a view as the bounding box of their union, snapped to whole pixels.
+class Damage
+{
+public:
+    Damage() : m_bounds(WKRectMake(0, 0, 0, 0)) {}
+
+    bool isEmpty() const { return m_bounds.size.width <= 0 || m_bounds.size.height <= 0; }
+    const WKRect& bounds() const { return m_bounds; }
+
+    void add(const WKRect& rect)
+    {
+        double left = std::floor(rect.origin.x);
+        double top = std::floor(rect.origin.y);
+        double right = std::ceil(rect.origin.x + rect.size.width);
+        double bottom = std::ceil(rect.origin.y + rect.size.height);
+        if (right <= left || bottom <= top)
+            return;
+
+        if (!isEmpty()) {
+            left = std::min(left, m_bounds.origin.x);
+            top = std::min(top, m_bounds.origin.y);
+            right = std::max(right, m_bounds.origin.x + m_bounds.size.width);
+            bottom = std::max(bottom, m_bounds.origin.y + m_bounds.size.height);
+        }
+        m_bounds = WKRectMake(left, top, right - left, bottom - top);
+    }
+
+    void add(const Damage& other)
+    {
+        if (!other.isEmpty())
+            add(other.m_bounds);
+    }
+
+    void intersect(const WKRect& rect)
+    {
+        if (isEmpty())
+            return;
+
+        double left = std::max(rect.origin.x, m_bounds.origin.x);
+        double top = std::max(rect.origin.y, m_bounds.origin.y);
+        double right = std::min(rect.origin.x + rect.size.width, m_bounds.origin.x + m_bounds.size.width);
+        double bottom = std::min(rect.origin.y + rect.size.height, m_bounds.origin.y + m_bounds.size.height);
+        if (right <= left || bottom <= top)
+            clear();
+        else
+            m_bounds = WKRectMake(left, top, right - left, bottom - top);
+    }
+
+    bool intersects(const WKRect& rect) const
+    {
+        Damage copy(*this);
+        copy.intersect(rect);
+        return !copy.isEmpty();
+    }
+
+    void translate(double dx, double dy)
+    {
+        m_bounds.origin.x += dx;
+        m_bounds.origin.y += dy;
+    }
+
+    void clear() { m_bounds = WKRectMake(0, 0, 0, 0); }
+
+private:
+    WKRect m_bounds;
+};
+
+#endif
@@ -25,11 +25,26 @@
 
 #include "DesktopWindow.h"
 
+#include <cstring>
+
 DesktopWindow::DesktopWindow(DesktopWindowClient* client, int width, int height)
-    : m_client(client), m_size(WKSizeMake(width, height))
+    : m_client(client), m_size(WKSizeMake(width, height)), m_inputEventTime(0)
 {
 }
 
 DesktopWindow::~DesktopWindow()
 {
 }
+
+bool hasExtension(const char* extensions, const char* name)
+{
+    if (!extensions)
+        return false;
+
+    size_t length = strlen(name);
+    for (const char* p = strstr(extensions, name); p; p = strstr(p + length, name)) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || !p[length]))
+            return true;
+    }
+    return false;
+}
@@ -28,6 +28,8 @@
 
 #include <WebKit2/WKGeometry.h>
 #include <NIXEvents.h>
+#include <ostream>
+#include <stdint.h>
 
 class DesktopWindowClient
 {
@@ -42,25 +44,71 @@ public:
 
     virtual void onWindowSizeChange(WKSize) = 0;
     virtual void onWindowClose() = 0;
+    // Called when the window becomes unmapped, minimized or fully covered by other windows, and back.
+    virtual void onWindowOcclusionChange(bool occluded) = 0;
+};
+
+// Whether the space separated extension list, as GL, GLX and EGL give them, has the extension.
+bool hasExtension(const char* extensions, const char* name);
+
+// How frames reach the screen. Automatic presents through shared memory on software renderers,
+// which spares the extra frame copy their buffer swaps do.
+enum PresentationMode {
+    AutomaticPresentation,
+    SwapPresentation,
+    SharedMemoryPresentation
 };
 
 class DesktopWindow
 {
 public:
     virtual ~DesktopWindow();
-    static DesktopWindow* create(DesktopWindowClient* client, int width, int height, bool visible=true);
+    static DesktopWindow* create(DesktopWindowClient* client, int width, int height, bool visible=true, PresentationMode=AutomaticPresentation);
+    // Offscreen window needing no display server, it never receives input nor expose events.
+    static DesktopWindow* createHeadless(DesktopWindowClient* client, int width, int height);
 
     WKSize size() const { return m_size; }
+    // The change is reported to the client once done, through onWindowSizeChange().
+    virtual void setSize(const WKSize&) = 0;
+    // For clients sitting between the window and the previous one.
+    void setClient(DesktopWindowClient* client) { m_client = client; }
     virtual void setMouseCursor(unsigned shape) = 0;
     virtual void setVisible(bool) = 0;
     virtual bool visible() const = 0;
     virtual void setPosition(const WKPoint& position) = 0;
 
     virtual void makeCurrent() = 0;
-    virtual void swapBuffers() = 0;
+    virtual void doneCurrent() = 0;
+    // Number of vblanks between buffer swaps, 0 disabling the synchronization. Needs the context current.
+    virtual bool setSwapInterval(int) { return false; }
+    // Called by the painting thread, with the context current, before painting a frame of the given
+    // size. size() may already have changed on the main thread, the frame keeps the one it was laid
+    // out for until it's presented.
+    virtual void beginFrame(const WKSize&) { }
+    // Framebuffer object the window contents are painted into, 0 being the window surface itself.
+    virtual unsigned framebuffer() { return 0; }
+    virtual const char* presentationMethod() const = 0;
+    // Age in frames of the back buffer contents, or 0 when they are undefined (see GLX_EXT_buffer_age).
+    virtual int bufferAge() = 0;
+    // Presents the back buffer; platforms able to do partial updates only copy the damaged rect.
+    virtual void swapBuffers(const WKRect& damagedRect) = 0;
+    // Time of the latest vblank and the refresh interval, in microseconds of the monotonic clock.
+    virtual bool vsyncTiming(int64_t& lastVBlank, int64_t& interval) { return false; }
+
+    virtual void dumpStatistics(std::ostream&) const { }
+
+    // Monotonic time, in microseconds, at which the input event being delivered to the client was
+    // received from the display server, or 0 when unknown or already taken.
+    int64_t takeInputEventTime()
+    {
+        int64_t time = m_inputEventTime;
+        m_inputEventTime = 0;
+        return time;
+    }
 protected:
     DesktopWindowClient* m_client;
     WKSize m_size;
+    int64_t m_inputEventTime;
 
     DesktopWindow(DesktopWindowClient* client, int width, int height);
 };
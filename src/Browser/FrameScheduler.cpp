@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FrameScheduler.h"
+
+#include "DesktopWindow.h"
+#include "MainLoopScheduling.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+static const gint64 defaultRefreshInterval = 1000000 / 60;
+static const gint64 minRefreshInterval = 1000000 / 240;
+static const gint64 maxRefreshInterval = 1000000 / 20;
+// A swap taking longer than this was throttled by the display.
+static const gint64 throttledSwapDuration = 2000;
+
+FrameScheduler::FrameScheduler(DesktopWindow* window, Client* client)
+    : m_window(window)
+    , m_client(client)
+    , m_timer(0)
+    , m_deadline(0)
+    , m_lastVBlank(0)
+    , m_interval(defaultRefreshInterval)
+    , m_hasDisplayTiming(false)
+    , m_calibratedInterval(defaultRefreshInterval)
+    , m_lastPresentTime(0)
+    , m_lastThrottledSwap(0)
+    , m_framesPresented(0)
+    , m_lateFrames(0)
+    , m_skippedVBlanks(0)
+    , m_coalescedRequests(0)
+{
+    assert(window);
+    assert(client);
+}
+
+FrameScheduler::~FrameScheduler()
+{
+    if (m_timer)
+        g_source_remove(m_timer);
+}
+
+void FrameScheduler::updateVSyncTiming(gint64 now)
+{
+    int64_t lastVBlank;
+    int64_t interval;
+    m_hasDisplayTiming = m_window->vsyncTiming(lastVBlank, interval)
+        && interval >= minRefreshInterval && interval <= maxRefreshInterval
+        && std::abs(now - lastVBlank) < G_USEC_PER_SEC;
+
+    if (m_hasDisplayTiming) {
+        m_lastVBlank = lastVBlank;
+        m_interval = interval;
+    } else {
+        m_lastVBlank = m_lastPresentTime;
+        m_interval = m_calibratedInterval;
+    }
+}
+
+void FrameScheduler::scheduleFrame()
+{
+    if (m_timer) {
+        ++m_coalescedRequests;
+        return;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    updateVSyncTiming(now);
+
+    // Nothing was presented recently, start right away.
+    gint64 start = now;
+    if (m_lastVBlank && now - m_lastVBlank < G_USEC_PER_SEC)
+        start = m_lastVBlank + ((now - m_lastVBlank) / m_interval + 1) * m_interval;
+
+    m_deadline = start + m_interval;
+    m_timer = scheduleTimeout(PaintClass, (start - now + 999) / 1000, frameTimerFired, this);
+}
+
+gboolean FrameScheduler::frameTimerFired(gpointer data)
+{
+    FrameScheduler* self = reinterpret_cast<FrameScheduler*>(data);
+    self->m_timer = 0;
+    self->m_client->updateDisplay();
+    return false;
+}
+
+void FrameScheduler::didPresentFrame(gint64 deadline, gint64 swapStart, gint64 swapEnd)
+{
+    ++m_framesPresented;
+    if (isLateFrame(deadline, swapStart)) {
+        ++m_lateFrames;
+        m_skippedVBlanks += (swapStart - deadline) / m_interval + 1;
+    }
+
+    // A blocking swap returns right after a vblank, which gives the timer fallback both the phase
+    // and, across consecutive frames, the refresh interval of the display.
+    if (swapEnd - swapStart > throttledSwapDuration) {
+        if (m_lastThrottledSwap) {
+            gint64 sample = swapEnd - m_lastThrottledSwap;
+            sample /= std::max<gint64>(1, (sample + m_calibratedInterval / 2) / m_calibratedInterval);
+            if (sample >= minRefreshInterval && sample <= maxRefreshInterval)
+                m_calibratedInterval = (7 * m_calibratedInterval + sample) / 8;
+        }
+        m_lastThrottledSwap = swapEnd;
+    }
+
+    m_lastPresentTime = swapEnd;
+}
+
+void FrameScheduler::dumpStatistics(std::ostream& out) const
+{
+    out << "Frames: " << m_framesPresented << " presented, "
+        << m_lateFrames << " late, "
+        << m_skippedVBlanks << " vblanks missed, "
+        << m_coalescedRequests << " requests coalesced, "
+        << "refresh interval " << m_interval << "us"
+        << (m_hasDisplayTiming ? " (display)" : " (timer)") << std::endl;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FrameScheduler_h
+#define FrameScheduler_h
+
+#include <glib.h>
+#include <ostream>
+
+class DesktopWindow;
+
+// Paces display updates to the refresh of the window's display. Frames are started on a vblank
+// and must be handed to the swap before the following one, otherwise they are counted as late.
+class FrameScheduler {
+public:
+    class Client {
+    public:
+        // Paints a frame, returns false if there was nothing to present.
+        virtual bool updateDisplay() = 0;
+    };
+
+    FrameScheduler(DesktopWindow*, Client*);
+    ~FrameScheduler();
+
+    void scheduleFrame();
+    bool frameScheduled() const { return m_timer; }
+
+    // Deadline of the frame being painted: its buffers must be swapped before this time.
+    gint64 deadline() const { return m_deadline; }
+    // Reports when the buffer swap of a frame started and finished.
+    void didPresentFrame(gint64 deadline, gint64 swapStart, gint64 swapEnd);
+    // A frame is late when its swap starts past its deadline, the HUD counts them the same way.
+    static bool isLateFrame(gint64 deadline, gint64 swapStart) { return deadline && swapStart > deadline; }
+
+    gint64 refreshInterval() const { return m_interval; }
+
+    void dumpStatistics(std::ostream&) const;
+
+private:
+    static gboolean frameTimerFired(gpointer);
+    void updateVSyncTiming(gint64 now);
+
+    DesktopWindow* m_window;
+    Client* m_client;
+    guint m_timer;
+    gint64 m_deadline;
+
+    gint64 m_lastVBlank;
+    gint64 m_interval;
+    bool m_hasDisplayTiming;
+
+    // Fallback timer, calibrated from swaps that block waiting for a vblank.
+    gint64 m_calibratedInterval;
+    gint64 m_lastPresentTime;
+    gint64 m_lastThrottledSwap;
+
+    unsigned m_framesPresented;
+    unsigned m_lateFrames;
+    unsigned m_skippedVBlanks;
+    unsigned m_coalescedRequests;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GLFramebuffer.h"
+
+GLFramebuffer::GLFramebuffer()
+    : m_fbo(0)
+    , m_texture(0)
+    , m_size(WKSizeMake(0, 0))
+    , m_complete(false)
+{
+    glGenFramebuffers(1, &m_fbo);
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+GLFramebuffer::~GLFramebuffer()
+{
+    glDeleteFramebuffers(1, &m_fbo);
+    glDeleteTextures(1, &m_texture);
+}
+
+bool GLFramebuffer::resize(const WKSize& size)
+{
+    if (size.width == m_size.width && size.height == m_size.height)
+        return false;
+
+    m_size = size;
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.width, size.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+    m_complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return true;
+}
+
+void GLFramebuffer::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_size.width, m_size.height);
+}
+
+void GLFramebuffer::blitTo(GLuint target, const WKRect& rect, const WKPoint& destination, int targetHeight)
+{
+    WKRect targetRect = WKRectMake(destination.x, destination.y, rect.size.width, rect.size.height);
+    blit(m_fbo, rect, m_size.height, target, targetRect, targetHeight);
+}
+
+void GLFramebuffer::blit(GLuint source, const WKRect& sourceRect, int sourceHeight, GLuint target, const WKRect& targetRect, int targetHeight)
+{
+    int sourceBottom = sourceHeight - (sourceRect.origin.y + sourceRect.size.height);
+    int targetBottom = targetHeight - (targetRect.origin.y + targetRect.size.height);
+    bool scaled = sourceRect.size.width != targetRect.size.width || sourceRect.size.height != targetRect.size.height;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(sourceRect.origin.x, sourceBottom, sourceRect.origin.x + sourceRect.size.width, sourceBottom + sourceRect.size.height,
+        targetRect.origin.x, targetBottom, targetRect.origin.x + targetRect.size.width, targetBottom + targetRect.size.height,
+        GL_COLOR_BUFFER_BIT, scaled ? GL_LINEAR : GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
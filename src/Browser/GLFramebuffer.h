@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GLFramebuffer_h
+#define GLFramebuffer_h
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <WebKit2/WKGeometry.h>
+
+// A framebuffer object rendering into a color texture. Must only be used while the GL context it
+// was created in is current.
+class GLFramebuffer {
+public:
+    GLFramebuffer();
+    ~GLFramebuffer();
+
+    // Returns true if the texture storage had to be reallocated, discarding its contents.
+    bool resize(const WKSize&);
+    WKSize size() const { return m_size; }
+    bool isComplete() const { return m_complete; }
+    GLuint id() const { return m_fbo; }
+    GLuint texture() const { return m_texture; }
+
+    void bind();
+
+    // Copies a rect, in top-left based coordinates of this framebuffer, to the given position of the
+    // target framebuffer, whose height is given.
+    void blitTo(GLuint target, const WKRect&, const WKPoint& destination, int targetHeight);
+    void blitTo(GLuint target, const WKRect& rect, int targetHeight) { blitTo(target, rect, rect.origin, targetHeight); }
+
+    // Copies, scaling if needed, between any two framebuffers, leaving the target one bound.
+    static void blit(GLuint source, const WKRect& sourceRect, int sourceHeight, GLuint target, const WKRect& targetRect, int targetHeight);
+
+private:
+    GLuint m_fbo;
+    GLuint m_texture;
+    WKSize m_size;
+    bool m_complete;
+};
+
+#endif
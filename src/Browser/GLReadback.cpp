@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GLReadback.h"
+
+GLReadback::GLReadback()
+    : m_buffer(0)
+    , m_fence(0)
+    , m_size(WKSizeMake(0, 0))
+{
+    glGenBuffers(1, &m_buffer);
+}
+
+GLReadback::~GLReadback()
+{
+    if (m_fence)
+        glDeleteSync(m_fence);
+    glDeleteBuffers(1, &m_buffer);
+}
+
+void GLReadback::start(GLuint framebuffer, const WKSize& size)
+{
+    if (m_fence)
+        glDeleteSync(m_fence);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffer);
+    if (size.width != m_size.width || size.height != m_size.height)
+        glBufferData(GL_PIXEL_PACK_BUFFER, size.width * size.height * 4, 0, GL_STREAM_READ);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, size.width, size.height, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_size = size;
+}
+
+bool GLReadback::isFinished()
+{
+    return m_fence && glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED;
+}
+
+const unsigned char* GLReadback::map()
+{
+    if (m_fence) {
+        glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(m_fence);
+        m_fence = 0;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffer);
+    const unsigned char* pixels = static_cast<const unsigned char*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    if (!pixels)
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return pixels;
+}
+
+void GLReadback::unmap()
+{
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GLReadback_h
+#define GLReadback_h
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <WebKit2/WKGeometry.h>
+
+// Reads a framebuffer back into a pixel buffer object, so glReadPixels returns without waiting for
+// the GPU. The BGRA pixels, bottom-up as GL reads them, are mapped once the readback completed.
+// Must only be used while the GL context it was created in is current.
+class GLReadback {
+public:
+    GLReadback();
+    ~GLReadback();
+
+    void start(GLuint framebuffer, const WKSize&);
+    bool isPending() const { return m_fence; }
+    bool isFinished();
+
+    // Waits for the readback if needed. The pixels stay valid until unmap(), only to be called
+    // when mapping succeeded.
+    const unsigned char* map();
+    void unmap();
+
+    WKSize size() const { return m_size; }
+
+private:
+    GLReadback(const GLReadback&) = delete;
+    GLReadback& operator=(const GLReadback&) = delete;
+
+    GLuint m_buffer;
+    GLsync m_fence;
+    WKSize m_size;
+};
+
+#endif
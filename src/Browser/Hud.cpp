@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Hud.h"
+
+#include "Compositor.h"
+#include "FrameScheduler.h"
+#include "GLFramebuffer.h"
+#include <algorithm>
+#include <cstdio>
+
+static const int hudWidth = 200;
+static const int hudHeight = 104;
+static const int hudMargin = 8;
+static const int lineHeight = 16;
+
+// Weight of the latest frame in the displayed averages.
+static const double smoothing = 1.0 / 16;
+
+static void accumulate(double& average, gint64 sample)
+{
+    average += (sample - average) * smoothing;
+}
+
+Hud::Hud()
+    : m_uiPaintTime(0)
+    , m_tabPaintTime(0)
+    , m_swapTime(0)
+    , m_frames(0)
+    , m_lateFrames(0)
+    , m_displayRequests(0)
+    , m_surface(0)
+    , m_framebuffer(0)
+{
+}
+
+Hud::~Hud()
+{
+    if (m_surface)
+        cairo_surface_destroy(m_surface);
+    delete m_framebuffer;
+}
+
+WKRect Hud::rect(const WKSize& windowSize, int toolBarHeight)
+{
+    return WKRectMake(std::max(0.0, windowSize.width - hudWidth - hudMargin), toolBarHeight + hudMargin, hudWidth, hudHeight);
+}
+
+void Hud::recordFrame(const CompositorFrame& frame)
+{
+    m_presentTimes.push_back(frame.swapEnd);
+    while (m_presentTimes.front() <= frame.swapEnd - G_USEC_PER_SEC)
+        m_presentTimes.pop_front();
+
+    accumulate(m_uiPaintTime, frame.uiPaintTime);
+    accumulate(m_tabPaintTime, frame.tabPaintTime);
+    accumulate(m_swapTime, frame.swapEnd - frame.swapStart);
+    ++m_frames;
+    if (FrameScheduler::isLateFrame(frame.deadline, frame.swapStart))
+        ++m_lateFrames;
+    m_displayRequests = frame.displayRequests;
+}
+
+void Hud::render()
+{
+    if (!m_surface)
+        m_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, hudWidth, hudHeight);
+
+    char lines[6][64];
+    snprintf(lines[0], sizeof(lines[0]), "%u fps", static_cast<unsigned>(m_presentTimes.size()));
+    snprintf(lines[1], sizeof(lines[1]), "UI paint: %.2f ms", m_uiPaintTime / 1000);
+    snprintf(lines[2], sizeof(lines[2]), "Tab paint: %.2f ms", m_tabPaintTime / 1000);
+    snprintf(lines[3], sizeof(lines[3]), "Swap: %.2f ms", m_swapTime / 1000);
+    snprintf(lines[4], sizeof(lines[4]), "Late frames: %u of %u", m_lateFrames, m_frames);
+    snprintf(lines[5], sizeof(lines[5]), "Display requests: %u", m_displayRequests);
+
+    cairo_t* cr = cairo_create(m_surface);
+    // GL textures are stored bottom up.
+    cairo_translate(cr, 0, hudHeight);
+    cairo_scale(cr, 1, -1);
+
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+    cairo_paint(cr);
+
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    cairo_select_font_face(cr, "monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 12);
+    for (int i = 0; i < 6; ++i) {
+        if (i == 4 && m_lateFrames)
+            cairo_set_source_rgb(cr, 1, 0.4, 0.4);
+        else
+            cairo_set_source_rgb(cr, 1, 1, 1);
+        cairo_move_to(cr, 6, lineHeight * (i + 1));
+        cairo_show_text(cr, lines[i]);
+    }
+    cairo_destroy(cr);
+    cairo_surface_flush(m_surface);
+}
+
+void Hud::paint(unsigned targetFramebuffer, const WKPoint& position, int targetHeight)
+{
+    if (!m_framebuffer) {
+        m_framebuffer = new GLFramebuffer;
+        m_framebuffer->resize(WKSizeMake(hudWidth, hudHeight));
+    }
+    if (!m_framebuffer->isComplete())
+        return;
+
+    render();
+
+    glBindTexture(GL_TEXTURE_2D, m_framebuffer->texture());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, cairo_image_surface_get_stride(m_surface) / 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, hudWidth, hudHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+        cairo_image_surface_get_data(m_surface));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Whatever falls outside of a small window is clipped by the blit.
+    m_framebuffer->blitTo(targetFramebuffer, WKRectMake(0, 0, hudWidth, hudHeight), position, targetHeight);
+}
+
+void Hud::releaseGLResources()
+{
+    delete m_framebuffer;
+    m_framebuffer = 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef Hud_h
+#define Hud_h
+
+#include <WebKit2/WKGeometry.h>
+#include <cairo.h>
+#include <deque>
+#include <glib.h>
+
+struct CompositorFrame;
+class GLFramebuffer;
+
+// Frame timing overlay painted by the compositor over the top right corner of the tab contents.
+// Timings are recorded for every frame, shown or not, so it only costs a few additions per frame
+// until it's toggled on. Only used from the thread owning the GL context.
+class Hud {
+public:
+    Hud();
+    ~Hud();
+
+    static WKRect rect(const WKSize& windowSize, int toolBarHeight);
+
+    void recordFrame(const CompositorFrame&);
+    void paint(unsigned targetFramebuffer, const WKPoint&, int targetHeight);
+    void releaseGLResources();
+
+private:
+    void render();
+
+    std::deque<gint64> m_presentTimes;
+    double m_uiPaintTime;
+    double m_tabPaintTime;
+    double m_swapTime;
+    unsigned m_frames;
+    unsigned m_lateFrames;
+    unsigned m_displayRequests;
+
+    cairo_surface_t* m_surface;
+    GLFramebuffer* m_framebuffer;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "InputLatency.h"
+
+#include <algorithm>
+
+static const size_t maxSamples = 1024;
+
+static const char* eventTypeName(InputEventType type)
+{
+    static const char* names[] = { "key press", "key release", "mouse press", "mouse release", "mouse move", "mouse wheel" };
+    static_assert(sizeof(names) / sizeof(names[0]) == InputEventTypeCount, "An input event type has no name");
+    return names[type];
+}
+
+static double percentile(const std::vector<gint64>& sorted, unsigned percent)
+{
+    size_t index = std::min(sorted.size() - 1, sorted.size() * percent / 100);
+    return sorted[index] / 1000.0;
+}
+
+void InputLatency::addSample(InputEventType type, gint64 latency)
+{
+    Samples& samples = m_samples[type];
+    if (samples.latencies.size() < maxSamples)
+        samples.latencies.push_back(latency);
+    else
+        samples.latencies[samples.next] = latency;
+    samples.next = (samples.next + 1) % maxSamples;
+    ++samples.count;
+}
+
+void InputLatency::dropStaleSample(InputEventType type)
+{
+    ++m_samples[type].stale;
+}
+
+void InputLatency::dumpStatistics(std::ostream& out) const
+{
+    out << "Input latency, over the last " << maxSamples << " events of each type:" << std::endl;
+    for (int type = 0; type < InputEventTypeCount; ++type) {
+        const Samples& samples = m_samples[type];
+        if (samples.latencies.empty())
+            continue;
+
+        std::vector<gint64> sorted = samples.latencies;
+        std::sort(sorted.begin(), sorted.end());
+        out << "  " << eventTypeName(InputEventType(type)) << ": p50 " << percentile(sorted, 50) << "ms, p95 "
+            << percentile(sorted, 95) << "ms, p99 " << percentile(sorted, 99) << "ms, max "
+            << sorted.back() / 1000.0 << "ms (" << samples.count << " events, " << samples.stale << " stale)" << std::endl;
+    }
+}
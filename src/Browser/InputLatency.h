@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef InputLatency_h
+#define InputLatency_h
+
+#include <glib.h>
+#include <ostream>
+#include <vector>
+
+enum InputEventType {
+    InputKeyPress,
+    InputKeyRelease,
+    InputMousePress,
+    InputMouseRelease,
+    InputMouseMove,
+    InputMouseWheel,
+    InputEventTypeCount
+};
+
+// Rolling latency distribution per input event type, from the moment the event was received from
+// the display server to the end of the buffer swap presenting the first frame painted after it.
+class InputLatency {
+public:
+    void addSample(InputEventType, gint64 latency);
+    // Counts an event whose latency is too long to be trusted.
+    void dropStaleSample(InputEventType);
+    void dumpStatistics(std::ostream&) const;
+
+private:
+    struct Samples {
+        Samples() : next(0), count(0), stale(0) { }
+
+        // Ring buffer of the latest latencies, next being the slot overwritten once full.
+        std::vector<gint64> latencies;
+        size_t next;
+        unsigned long count;
+        unsigned long stale;
+    };
+
+    Samples m_samples[InputEventTypeCount];
+};
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "InputRecorder.h"
+
+#include "FatalError.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+InputRecorder::InputRecorder(const std::string& fileName, DesktopWindowClient* client)
+    : m_client(client)
+    , m_file(fopen(fileName.c_str(), "wb"))
+    , m_lastRecordTime(0)
+    , m_records(0)
+{
+    if (!m_file)
+        throw FatalError("Could not create the input log " + fileName);
+    fwrite(inputLogMagic, sizeof(inputLogMagic), 1, m_file);
+    write(inputLogVersion);
+}
+
+InputRecorder::~InputRecorder()
+{
+    fclose(m_file);
+    std::cerr << "Recorded " << m_records << " input events." << std::endl;
+}
+
+void InputRecorder::writeRecordHeader(InputRecordKind kind)
+{
+    // The log starts with the first event, whenever it comes.
+    gint64 now = g_get_monotonic_time();
+    if (!m_lastRecordTime)
+        m_lastRecordTime = now;
+
+    write<uint8_t>(kind);
+    write<uint64_t>(now - m_lastRecordTime);
+    m_lastRecordTime = now;
+    ++m_records;
+}
+
+void InputRecorder::writeKeyEvent(InputRecordKind kind, const NIXKeyEvent& event)
+{
+    writeRecordHeader(kind);
+    write<uint32_t>(event.modifiers);
+    write<uint32_t>(event.key);
+    write<uint8_t>(event.isKeypad | event.shouldUseUpperCase << 1);
+    size_t length = event.text ? std::min<size_t>(strlen(event.text), 255) : 0;
+    write<uint8_t>(length);
+    fwrite(event.text, 1, length, m_file);
+}
+
+void InputRecorder::writeMouseEvent(InputRecordKind kind, const NIXMouseEvent& event)
+{
+    writeRecordHeader(kind);
+    write<uint32_t>(event.modifiers);
+    write<uint8_t>(event.button);
+    write<int32_t>(event.x);
+    write<int32_t>(event.y);
+    write<int32_t>(event.globalX);
+    write<int32_t>(event.globalY);
+    write<uint8_t>(event.clickCount);
+}
+
+void InputRecorder::onWindowExpose()
+{
+    m_client->onWindowExpose();
+}
+
+void InputRecorder::onKeyPress(NIXKeyEvent* event)
+{
+    writeKeyEvent(KeyPressRecord, *event);
+    m_client->onKeyPress(event);
+}
+
+void InputRecorder::onKeyRelease(NIXKeyEvent* event)
+{
+    writeKeyEvent(KeyReleaseRecord, *event);
+    m_client->onKeyRelease(event);
+}
+
+void InputRecorder::onMousePress(NIXMouseEvent* event)
+{
+    writeMouseEvent(MousePressRecord, *event);
+    m_client->onMousePress(event);
+}
+
+void InputRecorder::onMouseRelease(NIXMouseEvent* event)
+{
+    writeMouseEvent(MouseReleaseRecord, *event);
+    m_client->onMouseRelease(event);
+}
+
+void InputRecorder::onMouseMove(NIXMouseEvent* event)
+{
+    writeMouseEvent(MouseMoveRecord, *event);
+    m_client->onMouseMove(event);
+}
+
+void InputRecorder::onMouseWheel(NIXWheelEvent* event)
+{
+    writeRecordHeader(MouseWheelRecord);
+    write<uint32_t>(event->modifiers);
+    write<int32_t>(event->x);
+    write<int32_t>(event->y);
+    write<int32_t>(event->globalX);
+    write<int32_t>(event->globalY);
+    write<float>(event->delta);
+    write<uint8_t>(event->orientation);
+    m_client->onMouseWheel(event);
+}
+
+void InputRecorder::onWindowSizeChange(WKSize size)
+{
+    writeRecordHeader(WindowSizeRecord);
+    write<uint32_t>(size.width);
+    write<uint32_t>(size.height);
+    m_client->onWindowSizeChange(size);
+}
+
+void InputRecorder::onWindowClose()
+{
+    m_client->onWindowClose();
+}
+
+void InputRecorder::onWindowOcclusionChange(bool occluded)
+{
+    m_client->onWindowOcclusionChange(occluded);
+}
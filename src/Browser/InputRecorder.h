@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef InputRecorder_h
+#define InputRecorder_h
+
+#include "DesktopWindow.h"
+#include <cstdio>
+#include <glib.h>
+#include <string>
+
+// Kinds of the records in an input log. The log starts with inputLogMagic and inputLogVersion, then
+// each record is its kind in a byte, the microseconds since the previous record in 64 bits and the
+// fields of the event, all in native byte order.
+enum InputRecordKind {
+    KeyPressRecord,
+    KeyReleaseRecord,
+    MousePressRecord,
+    MouseReleaseRecord,
+    MouseMoveRecord,
+    MouseWheelRecord,
+    WindowSizeRecord
+};
+
+static const char inputLogMagic[4] = { 'D', 'R', 'I', 'L' };
+static const uint32_t inputLogVersion = 2;
+
+// Sits between a window and its client, logging the input events and size changes on their way.
+class InputRecorder : public DesktopWindowClient {
+public:
+    // Throws FatalError if the log can't be created.
+    InputRecorder(const std::string& fileName, DesktopWindowClient*);
+    virtual ~InputRecorder();
+
+    virtual void onWindowExpose();
+    virtual void onKeyPress(NIXKeyEvent*);
+    virtual void onKeyRelease(NIXKeyEvent*);
+    virtual void onMousePress(NIXMouseEvent*);
+    virtual void onMouseRelease(NIXMouseEvent*);
+    virtual void onMouseMove(NIXMouseEvent*);
+    virtual void onMouseWheel(NIXWheelEvent*);
+    virtual void onWindowSizeChange(WKSize);
+    virtual void onWindowClose();
+    virtual void onWindowOcclusionChange(bool occluded);
+
+private:
+    void writeRecordHeader(InputRecordKind);
+    void writeKeyEvent(InputRecordKind, const NIXKeyEvent&);
+    void writeMouseEvent(InputRecordKind, const NIXMouseEvent&);
+    template<typename T> void write(T value) { fwrite(&value, sizeof(value), 1, m_file); }
+
+    DesktopWindowClient* m_client;
+    FILE* m_file;
+    gint64 m_lastRecordTime;
+    unsigned m_records;
+};
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "InputReplayer.h"
+
+#include "FatalError.h"
+#include "InputRecorder.h"
+#include "MainLoopScheduling.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+InputReplayer::InputReplayer(const std::string& fileName, DesktopWindow* window, DesktopWindowClient* windowClient, Client* client, bool paced)
+    : m_window(window)
+    , m_windowClient(windowClient)
+    , m_client(client)
+    , m_paced(paced)
+    , m_position(0)
+    , m_timer(0)
+    , m_startTime(0)
+    , m_recordOffset(0)
+    , m_eventTime(0)
+    , m_events(0)
+{
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if (!file)
+        throw FatalError("Could not open the input log " + fileName);
+    m_log.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    char magic[sizeof(inputLogMagic)];
+    uint32_t version = 0;
+    for (size_t i = 0; i < sizeof(magic); ++i)
+        read(magic[i]);
+    if (memcmp(magic, inputLogMagic, sizeof(magic)) || !read(version) || version != inputLogVersion)
+        throw FatalError(fileName + " is not an input log this version can replay");
+}
+
+InputReplayer::~InputReplayer()
+{
+    if (m_timer)
+        g_source_remove(m_timer);
+}
+
+void InputReplayer::start()
+{
+    if (m_startTime)
+        return;
+    m_startTime = g_get_monotonic_time();
+    scheduleNextRecord();
+}
+
+void InputReplayer::scheduleNextRecord()
+{
+    uint8_t kind;
+    uint64_t delay;
+    size_t position = m_position;
+    if (!read(kind) || !read(delay)) {
+        std::cerr << "Replayed " << m_events << " input events in "
+            << (g_get_monotonic_time() - m_startTime) / 1000 << "ms." << std::endl;
+        m_client->didFinishReplay();
+        return;
+    }
+    m_position = position;
+
+    m_recordOffset += delay;
+    gint64 wait = 0;
+    if (m_paced)
+        wait = std::max<gint64>(0, m_startTime + m_recordOffset - g_get_monotonic_time());
+    m_timer = scheduleTimeout(InputClass, wait / 1000, replayTimerFired, this);
+}
+
+gboolean InputReplayer::replayTimerFired(gpointer data)
+{
+    InputReplayer* self = reinterpret_cast<InputReplayer*>(data);
+    self->m_timer = 0;
+    if (!self->replayRecord()) {
+        std::cerr << "The input log is truncated." << std::endl;
+        self->m_position = self->m_log.size();
+    }
+    self->scheduleNextRecord();
+    return false;
+}
+
+bool InputReplayer::readKeyEvent(NIXKeyEvent& event, std::string& text)
+{
+    uint32_t modifiers;
+    uint32_t key;
+    uint8_t flags;
+    uint8_t length;
+    if (!read(modifiers) || !read(key) || !read(flags) || !read(length) || m_log.size() - m_position < length)
+        return false;
+
+    text.assign(reinterpret_cast<const char*>(&m_log[m_position]), length);
+    m_position += length;
+
+    memset(&event, 0, sizeof(event));
+    event.modifiers = modifiers;
+    event.key = static_cast<NIXKeyEventKey>(key);
+    event.isKeypad = flags & 1;
+    event.shouldUseUpperCase = flags & 2;
+    event.text = length ? text.c_str() : 0;
+    return true;
+}
+
+bool InputReplayer::readMouseEvent(NIXMouseEvent& event)
+{
+    uint32_t modifiers;
+    uint8_t button;
+    int32_t x, y, globalX, globalY;
+    uint8_t clickCount;
+    if (!read(modifiers) || !read(button) || !read(x) || !read(y) || !read(globalX) || !read(globalY) || !read(clickCount))
+        return false;
+
+    memset(&event, 0, sizeof(event));
+    event.modifiers = modifiers;
+    event.button = static_cast<WKEventMouseButton>(button);
+    event.x = x;
+    event.y = y;
+    event.globalX = globalX;
+    event.globalY = globalY;
+    event.clickCount = clickCount;
+    return true;
+}
+
+bool InputReplayer::replayRecord()
+{
+    uint8_t kind;
+    uint64_t delay;
+    read(kind);
+    read(delay);
+
+    // Timestamps keep the recorded spacing whatever the pace, WebKit tells clicks from double
+    // clicks and flings from them.
+    m_eventTime = g_get_monotonic_time();
+    double timestamp = (m_startTime + m_recordOffset) / double(G_USEC_PER_SEC);
+    ++m_events;
+
+    switch (kind) {
+    case KeyPressRecord:
+    case KeyReleaseRecord: {
+        NIXKeyEvent event;
+        std::string text;
+        if (!readKeyEvent(event, text))
+            return false;
+        event.type = kind == KeyPressRecord ? kNIXInputEventTypeKeyDown : kNIXInputEventTypeKeyUp;
+        event.timestamp = timestamp;
+        if (kind == KeyPressRecord)
+            m_windowClient->onKeyPress(&event);
+        else
+            m_windowClient->onKeyRelease(&event);
+        return true;
+    }
+    case MousePressRecord:
+    case MouseReleaseRecord:
+    case MouseMoveRecord: {
+        NIXMouseEvent event;
+        if (!readMouseEvent(event))
+            return false;
+        event.timestamp = timestamp;
+        if (kind == MousePressRecord) {
+            event.type = kNIXInputEventTypeMouseDown;
+            m_windowClient->onMousePress(&event);
+        } else if (kind == MouseReleaseRecord) {
+            event.type = kNIXInputEventTypeMouseUp;
+            m_windowClient->onMouseRelease(&event);
+        } else {
+            event.type = kNIXInputEventTypeMouseMove;
+            m_windowClient->onMouseMove(&event);
+        }
+        return true;
+    }
+    case MouseWheelRecord: {
+        uint32_t modifiers;
+        int32_t x, y, globalX, globalY;
+        float delta;
+        uint8_t orientation;
+        if (!read(modifiers) || !read(x) || !read(y) || !read(globalX) || !read(globalY) || !read(delta) || !read(orientation))
+            return false;
+
+        NIXWheelEvent event;
+        memset(&event, 0, sizeof(event));
+        event.type = kNIXInputEventTypeWheel;
+        event.modifiers = modifiers;
+        event.timestamp = timestamp;
+        event.x = x;
+        event.y = y;
+        event.globalX = globalX;
+        event.globalY = globalY;
+        event.delta = delta;
+        event.orientation = static_cast<NIXWheelEventOrientation>(orientation);
+        m_windowClient->onMouseWheel(&event);
+        return true;
+    }
+    case WindowSizeRecord: {
+        uint32_t width, height;
+        if (!read(width) || !read(height))
+            return false;
+        // The window reports the change back through onWindowSizeChange().
+        m_window->setSize(WKSizeMake(width, height));
+        return true;
+    }
+    }
+    return false;
+}
+
+void InputReplayer::onWindowExpose()
+{
+    m_windowClient->onWindowExpose();
+}
+
+void InputReplayer::onWindowSizeChange(WKSize size)
+{
+    m_windowClient->onWindowSizeChange(size);
+}
+
+void InputReplayer::onWindowClose()
+{
+    m_windowClient->onWindowClose();
+}
+
+void InputReplayer::onWindowOcclusionChange(bool occluded)
+{
+    m_windowClient->onWindowOcclusionChange(occluded);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef InputReplayer_h
+#define InputReplayer_h
+
+#include "DesktopWindow.h"
+#include <cstring>
+#include <glib.h>
+#include <string>
+#include <vector>
+
+// Sits between a window and its client, feeding the client the events of an input log written by
+// InputRecorder instead of the live input. Size changes in the log resize the window.
+class InputReplayer : public DesktopWindowClient {
+public:
+    class Client {
+    public:
+        virtual void didFinishReplay() = 0;
+    };
+
+    // Throws FatalError if the log can't be read. Unless paced, events are replayed as fast as
+    // the main loop goes, each in its own iteration.
+    InputReplayer(const std::string& fileName, DesktopWindow*, DesktopWindowClient*, Client*, bool paced);
+    virtual ~InputReplayer();
+
+    void start();
+    // Monotonic time at which the event being replayed was due, or 0 once taken.
+    gint64 takeEventTime()
+    {
+        gint64 time = m_eventTime;
+        m_eventTime = 0;
+        return time;
+    }
+
+    virtual void onWindowExpose();
+    virtual void onKeyPress(NIXKeyEvent*) { }
+    virtual void onKeyRelease(NIXKeyEvent*) { }
+    virtual void onMousePress(NIXMouseEvent*) { }
+    virtual void onMouseRelease(NIXMouseEvent*) { }
+    virtual void onMouseMove(NIXMouseEvent*) { }
+    virtual void onMouseWheel(NIXWheelEvent*) { }
+    virtual void onWindowSizeChange(WKSize);
+    virtual void onWindowClose();
+    virtual void onWindowOcclusionChange(bool occluded);
+
+private:
+    static gboolean replayTimerFired(gpointer);
+    void scheduleNextRecord();
+    bool replayRecord();
+    bool readKeyEvent(NIXKeyEvent&, std::string& text);
+    bool readMouseEvent(NIXMouseEvent&);
+    template<typename T> bool read(T& value)
+    {
+        if (m_log.size() - m_position < sizeof(value))
+            return false;
+        memcpy(&value, &m_log[m_position], sizeof(value));
+        m_position += sizeof(value);
+        return true;
+    }
+
+    DesktopWindow* m_window;
+    DesktopWindowClient* m_windowClient;
+    Client* m_client;
+    bool m_paced;
+
+    std::vector<unsigned char> m_log;
+    size_t m_position;
+    guint m_timer;
+    gint64 m_startTime;
+    // Time the next record is due at, relative to the start of the replay.
+    gint64 m_recordOffset;
+    gint64 m_eventTime;
+    unsigned m_events;
+};
+
+#endif
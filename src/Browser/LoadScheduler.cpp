@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LoadScheduler.h"
+
+#include "MainLoopScheduling.h"
+#include "Tab.h"
+#include <algorithm>
+
+// How long hidden tabs wait for the visible one, which may never finish loading.
+static const gint64 visibleLoadTimeout = 10 * G_USEC_PER_SEC;
+
+LoadScheduler::LoadScheduler(unsigned maxConcurrentLoads)
+    : m_maxConcurrentLoads(std::max(1u, maxConcurrentLoads))
+    , m_visibleTab(0)
+    , m_visibleSince(0)
+    , m_visibleLoadTimedOut(false)
+    , m_restoringTab(0)
+    , m_restoreStart(0)
+    , m_pumpSource(0)
+    , m_visibleLoadTimeoutSource(0)
+    , m_loadsScheduled(0)
+    , m_startTime(0)
+    , m_firstVisibleLoadTime(0)
+    , m_allLoadsTime(0)
+    , m_visibleLoadTimeouts(0)
+    , m_restoresLoaded(0)
+    , m_restoreLoadTimeTotal(0)
+    , m_restoreLoadTimeMax(0)
+{
+}
+
+LoadScheduler::~LoadScheduler()
+{
+    if (m_pumpSource)
+        g_source_remove(m_pumpSource);
+    if (m_visibleLoadTimeoutSource)
+        g_source_remove(m_visibleLoadTimeoutSource);
+}
+
+void LoadScheduler::enqueue(Tab* tab, const std::string& url)
+{
+    if (!m_startTime)
+        m_startTime = g_get_monotonic_time();
+    m_allLoadsTime = 0;
+    ++m_loadsScheduled;
+
+    Load load = { tab, url };
+    m_queue.push_back(load);
+    // Waiting for idle time lets the UI tell which tab is shown first.
+    schedulePump();
+}
+
+bool LoadScheduler::hasPendingLoad(Tab* tab) const
+{
+    if (isLoading(tab))
+        return true;
+    return std::find_if(m_queue.begin(), m_queue.end(), [tab](const Load& load) {
+        return load.tab == tab;
+    }) != m_queue.end();
+}
+
+void LoadScheduler::tabShown(Tab* tab)
+{
+    m_visibleTab = tab;
+    m_visibleSince = g_get_monotonic_time();
+    m_visibleLoadTimedOut = false;
+    // A restore that never finished, its latency is meaningless once the tab is left.
+    if (tab != m_restoringTab)
+        m_restoringTab = 0;
+    for (std::deque<Load>::iterator it = m_queue.begin(); it != m_queue.end(); ++it) {
+        if (it->tab == tab) {
+            Load load = *it;
+            m_queue.erase(it);
+            start(load);
+            return;
+        }
+    }
+    // The hidden tabs were maybe waiting for the one shown before.
+    schedulePump();
+}
+
+void LoadScheduler::didRestoreTab(Tab* tab)
+{
+    m_restoringTab = tab;
+    m_restoreStart = g_get_monotonic_time();
+}
+
+void LoadScheduler::didFinishLoad(Tab* tab)
+{
+    if (tab == m_restoringTab) {
+        gint64 loadTime = g_get_monotonic_time() - m_restoreStart;
+        m_restoringTab = 0;
+        ++m_restoresLoaded;
+        m_restoreLoadTimeTotal += loadTime;
+        m_restoreLoadTimeMax = std::max(m_restoreLoadTimeMax, loadTime);
+        schedulePump();
+    }
+
+    std::vector<Tab*>::iterator it = std::find(m_activeLoads.begin(), m_activeLoads.end(), tab);
+    if (it == m_activeLoads.end())
+        return;
+    m_activeLoads.erase(it);
+
+    gint64 now = g_get_monotonic_time();
+    if (tab == m_visibleTab && !m_firstVisibleLoadTime)
+        m_firstVisibleLoadTime = now - m_startTime;
+    if (m_queue.empty() && m_activeLoads.empty())
+        m_allLoadsTime = now - m_startTime;
+    schedulePump();
+}
+
+void LoadScheduler::didCloseTab(Tab* tab)
+{
+    if (tab == m_visibleTab)
+        m_visibleTab = 0;
+    if (tab == m_restoringTab)
+        m_restoringTab = 0;
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [tab](const Load& load) {
+        return load.tab == tab;
+    }), m_queue.end());
+    // Frees its slot.
+    didFinishLoad(tab);
+}
+
+void LoadScheduler::start(const Load& load)
+{
+    m_activeLoads.push_back(load.tab);
+    load.tab->loadUrl(load.url);
+}
+
+bool LoadScheduler::isLoading(Tab* tab) const
+{
+    return std::find(m_activeLoads.begin(), m_activeLoads.end(), tab) != m_activeLoads.end();
+}
+
+bool LoadScheduler::isVisibleTabLoading() const
+{
+    return m_visibleTab && (isLoading(m_visibleTab) || m_visibleTab == m_restoringTab);
+}
+
+void LoadScheduler::schedulePump()
+{
+    if (m_pumpSource || m_queue.empty())
+        return;
+    m_pumpSource = scheduleIdle(BackgroundClass, pumpCallback, this);
+}
+
+gboolean LoadScheduler::pumpCallback(gpointer data)
+{
+    LoadScheduler* self = reinterpret_cast<LoadScheduler*>(data);
+    self->m_pumpSource = 0;
+    self->pump();
+    return false;
+}
+
+gboolean LoadScheduler::visibleLoadTimeoutCallback(gpointer data)
+{
+    LoadScheduler* self = reinterpret_cast<LoadScheduler*>(data);
+    self->m_visibleLoadTimeoutSource = 0;
+    self->schedulePump();
+    return false;
+}
+
+void LoadScheduler::pump()
+{
+    // Hidden tabs would compete with the visible one for the network and the CPU.
+    if (!m_queue.empty() && !m_visibleLoadTimedOut && isVisibleTabLoading()) {
+        gint64 remaining = m_visibleSince + visibleLoadTimeout - g_get_monotonic_time();
+        if (remaining > 0) {
+            if (!m_visibleLoadTimeoutSource)
+                m_visibleLoadTimeoutSource = scheduleTimeout(BackgroundClass, remaining / 1000 + 1, visibleLoadTimeoutCallback, this);
+            return;
+        }
+        m_visibleLoadTimedOut = true;
+        ++m_visibleLoadTimeouts;
+    }
+
+    while (!m_queue.empty() && m_activeLoads.size() < m_maxConcurrentLoads) {
+        Load load = m_queue.front();
+        m_queue.pop_front();
+        start(load);
+    }
+}
+
+void LoadScheduler::dumpStatistics(std::ostream& out) const
+{
+    out << "Scheduled loads: " << m_loadsScheduled;
+    if (m_firstVisibleLoadTime)
+        out << ", visible tab loaded after " << m_firstVisibleLoadTime / 1000.0 << "ms";
+    if (m_allLoadsTime)
+        out << ", all tabs loaded after " << m_allLoadsTime / 1000.0 << "ms";
+    else if (m_loadsScheduled)
+        out << ", " << m_activeLoads.size() << " loading, " << m_queue.size() << " waiting";
+    if (m_visibleLoadTimeouts)
+        out << ", " << m_visibleLoadTimeouts << " visible loads timed out";
+    if (m_restoresLoaded) {
+        out << ", restored tabs loaded after " << m_restoreLoadTimeTotal / m_restoresLoaded / 1000.0 << "ms on average, "
+            << m_restoreLoadTimeMax / 1000.0 << "ms max";
+    }
+    out << std::endl;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LoadScheduler_h
+#define LoadScheduler_h
+
+#include <glib.h>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Tab;
+
+// Staggers the loads of the tabs opened at startup. The visible tab loads first, regardless of
+// the limit, and the others wait for it to finish before starting, a few at a time, in idle time.
+// They stop waiting for a visible load, or the reload of a restored tab, after visibleLoadTimeout.
+class LoadScheduler {
+public:
+    explicit LoadScheduler(unsigned maxConcurrentLoads);
+    ~LoadScheduler();
+
+    void enqueue(Tab*, const std::string& url);
+    // Queued or loading. Such a tab must keep its page until the load is done.
+    bool hasPendingLoad(Tab*) const;
+
+    void tabShown(Tab*);
+    // The tab reloads its page from its session state. It isn't a scheduled load, but hidden tabs
+    // wait for it while it's shown.
+    void didRestoreTab(Tab*);
+    void didFinishLoad(Tab*);
+    void didCloseTab(Tab*);
+
+    void dumpStatistics(std::ostream&) const;
+
+private:
+    struct Load {
+        Tab* tab;
+        std::string url;
+    };
+
+    void start(const Load&);
+    void schedulePump();
+    static gboolean pumpCallback(gpointer);
+    void pump();
+    bool isLoading(Tab*) const;
+    bool isVisibleTabLoading() const;
+    static gboolean visibleLoadTimeoutCallback(gpointer);
+
+    unsigned m_maxConcurrentLoads;
+    std::deque<Load> m_queue;
+    std::vector<Tab*> m_activeLoads;
+    Tab* m_visibleTab;
+    gint64 m_visibleSince;
+    bool m_visibleLoadTimedOut;
+    Tab* m_restoringTab;
+    gint64 m_restoreStart;
+    guint m_pumpSource;
+    guint m_visibleLoadTimeoutSource;
+
+    unsigned m_loadsScheduled;
+    gint64 m_startTime;
+    gint64 m_firstVisibleLoadTime;
+    gint64 m_allLoadsTime;
+    unsigned m_visibleLoadTimeouts;
+    unsigned m_restoresLoaded;
+    gint64 m_restoreLoadTimeTotal;
+    gint64 m_restoreLoadTimeMax;
+};
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MainLoopScheduling.h"
+
+#include <vector>
+
+struct ScheduledCall {
+    SchedulingClass schedulingClass;
+    GSourceFunc function;
+    gpointer data;
+    GSource* source;
+    guint interval;
+    gint64 dueTime;
+    bool raised;
+};
+
+struct SchedulingStatistics {
+    unsigned dispatches;
+    gint64 time;
+    gint64 maxTime;
+    unsigned starved;
+};
+
+static const char* schedulingClassNames[] = { "input", "paint", "bookkeeping", "background" };
+static_assert(sizeof(schedulingClassNames) / sizeof(schedulingClassNames[0]) == SchedulingClassCount, "A scheduling class has no name");
+
+// How long past its due time a source may wait before being raised above everything else. Input
+// is never raised: no class is more urgent, and replayed input, the only input on timers, would
+// count as starved as soon as it's due.
+static const gint64 maxStarvation[] = { G_MAXINT64, 8000, 50000, 1000000 };
+
+// Calls waiting to be dispatched, checked for starvation on every main loop iteration.
+static GMutex pendingCallsMutex;
+static std::vector<ScheduledCall*> pendingCalls;
+static GSource* starvationWatchdog;
+// Only touched on the main thread.
+static SchedulingStatistics statistics[SchedulingClassCount];
+
+gint schedulingPriority(SchedulingClass schedulingClass)
+{
+    switch (schedulingClass) {
+    case InputClass:
+        return G_PRIORITY_HIGH;
+    case PaintClass:
+        return (G_PRIORITY_HIGH + G_PRIORITY_DEFAULT) / 2;
+    case BookkeepingClass:
+        return G_PRIORITY_HIGH_IDLE;
+    case BackgroundClass:
+    case SchedulingClassCount:
+        break;
+    }
+    return G_PRIORITY_LOW;
+}
+
+static void raiseStarvedCalls(gint64 now)
+{
+    g_mutex_lock(&pendingCallsMutex);
+    for (ScheduledCall* call : pendingCalls) {
+        if (call->raised || now - call->dueTime <= maxStarvation[call->schedulingClass])
+            continue;
+        call->raised = true;
+        g_source_set_priority(call->source, schedulingPriority(InputClass) - 1);
+        ++statistics[call->schedulingClass].starved;
+    }
+    g_mutex_unlock(&pendingCallsMutex);
+}
+
+// Sources are prepared in priority order, so at the top priority the watchdog is prepared on every
+// iteration, whatever keeps the loop busy: WebKit IPC or X events starve our sources just as well.
+// It never dispatches.
+static gboolean starvationWatchdogPrepare(GSource* source, gint* timeout)
+{
+    *timeout = -1;
+    raiseStarvedCalls(g_source_get_time(source));
+    return false;
+}
+
+static gboolean starvationWatchdogCheck(GSource*)
+{
+    return false;
+}
+
+static gboolean starvationWatchdogDispatch(GSource*, GSourceFunc, gpointer)
+{
+    return true;
+}
+
+static GSourceFuncs starvationWatchdogFuncs = {
+    starvationWatchdogPrepare,
+    starvationWatchdogCheck,
+    starvationWatchdogDispatch,
+    0
+};
+
+void accountDispatch(SchedulingClass schedulingClass, gint64 start)
+{
+    gint64 now = g_get_monotonic_time();
+    SchedulingStatistics& classStatistics = statistics[schedulingClass];
+    ++classStatistics.dispatches;
+    classStatistics.time += now - start;
+    if (now - start > classStatistics.maxTime)
+        classStatistics.maxTime = now - start;
+}
+
+static gboolean dispatchScheduledCall(gpointer data)
+{
+    ScheduledCall* call = reinterpret_cast<ScheduledCall*>(data);
+    gint64 start = g_get_monotonic_time();
+    bool again = call->function(call->data);
+
+    if (again) {
+        g_mutex_lock(&pendingCallsMutex);
+        call->dueTime = g_get_monotonic_time() + call->interval * 1000;
+        if (call->raised) {
+            call->raised = false;
+            g_source_set_priority(call->source, schedulingPriority(call->schedulingClass));
+        }
+        g_mutex_unlock(&pendingCallsMutex);
+    }
+
+    accountDispatch(call->schedulingClass, start);
+    return again;
+}
+
+static void destroyScheduledCall(gpointer data)
+{
+    ScheduledCall* call = reinterpret_cast<ScheduledCall*>(data);
+    g_mutex_lock(&pendingCallsMutex);
+    for (size_t i = 0; i < pendingCalls.size(); ++i) {
+        if (pendingCalls[i] == call) {
+            pendingCalls[i] = pendingCalls.back();
+            pendingCalls.pop_back();
+            break;
+        }
+    }
+    g_mutex_unlock(&pendingCallsMutex);
+    delete call;
+}
+
+static guint schedule(GSource* source, SchedulingClass schedulingClass, guint interval, GSourceFunc function, gpointer data)
+{
+    ScheduledCall* call = new ScheduledCall;
+    call->schedulingClass = schedulingClass;
+    call->function = function;
+    call->data = data;
+    call->source = source;
+    call->interval = interval;
+    call->dueTime = g_get_monotonic_time() + interval * 1000;
+    call->raised = false;
+
+    g_mutex_lock(&pendingCallsMutex);
+    pendingCalls.push_back(call);
+    if (!starvationWatchdog) {
+        starvationWatchdog = g_source_new(&starvationWatchdogFuncs, sizeof(GSource));
+        g_source_set_priority(starvationWatchdog, schedulingPriority(InputClass) - 1);
+        g_source_attach(starvationWatchdog, 0);
+    }
+    g_mutex_unlock(&pendingCallsMutex);
+
+    g_source_set_priority(source, schedulingPriority(schedulingClass));
+    g_source_set_callback(source, dispatchScheduledCall, call, destroyScheduledCall);
+    guint id = g_source_attach(source, 0);
+    g_source_unref(source);
+    return id;
+}
+
+guint scheduleTimeout(SchedulingClass schedulingClass, guint interval, GSourceFunc function, gpointer data)
+{
+    return schedule(g_timeout_source_new(interval), schedulingClass, interval, function, data);
+}
+
+guint scheduleIdle(SchedulingClass schedulingClass, GSourceFunc function, gpointer data)
+{
+    return schedule(g_idle_source_new(), schedulingClass, 0, function, data);
+}
+
+void dumpSchedulingStatistics(std::ostream& out)
+{
+    out << "Main loop:";
+    for (int i = 0; i < SchedulingClassCount; ++i) {
+        const SchedulingStatistics& classStatistics = statistics[i];
+        out << (i ? "; " : " ") << schedulingClassNames[i] << " " << classStatistics.time / 1000 << "ms in "
+            << classStatistics.dispatches << " dispatches, " << classStatistics.maxTime / 1000.0 << "ms max";
+        if (classStatistics.starved)
+            out << ", " << classStatistics.starved << " starved";
+    }
+    out << std::endl;
+}
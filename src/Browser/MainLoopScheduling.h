@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MainLoopScheduling_h
+#define MainLoopScheduling_h
+
+#include <glib.h>
+#include <ostream>
+
+// Classes of main loop work, from the most to the least urgent. WebKit's IPC runs at the default
+// priority, between painting and bookkeeping.
+enum SchedulingClass {
+    // Handling events from the display server.
+    InputClass,
+    // Frames at their deadline, and whatever feeds back into the frame timing.
+    PaintClass,
+    // Reacting to finished work: collecting readbacks, notifications, timeouts.
+    BookkeepingClass,
+    // Anything able to wait for the loop to be idle.
+    BackgroundClass,
+    SchedulingClassCount
+};
+
+gint schedulingPriority(SchedulingClass);
+
+// Like g_timeout_add() and g_idle_add(), at the priority of the class, with the dispatch time
+// accounted to it. A source kept waiting past its due time by more urgent classes for too long
+// is raised above them until it runs, whatever the loop is busy with meanwhile. scheduleIdle() may
+// be called from any thread.
+guint scheduleTimeout(SchedulingClass, guint interval, GSourceFunc, gpointer);
+guint scheduleIdle(SchedulingClass, GSourceFunc, gpointer);
+
+// For sources created elsewhere: accounts a dispatch of the class started at the given time.
+void accountDispatch(SchedulingClass, gint64 start);
+
+void dumpSchedulingStatistics(std::ostream&);
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ProcessModel.h"
+
+#include "Tab.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+ProcessModel::ProcessModel(Kind kind, unsigned maxProcesses)
+    : m_kind(kind)
+    , m_maxProcesses(std::max(1u, maxProcesses))
+    , m_processesCreated(0)
+    , m_sharedAssignments(0)
+{
+}
+
+ProcessModel::~ProcessModel()
+{
+    for (Process& process : m_processes)
+        WKRelease(process.context);
+}
+
+WKContextRef ProcessModel::contextForUrl(const std::string& url)
+{
+    if (m_kind == ProcessPerTab) {
+        ++m_processesCreated;
+        return Tab::createContext();
+    }
+
+    std::string site;
+    if (m_kind == ProcessPerSite)
+        site = registrableDomain(url);
+
+    Process* process = 0;
+    if (m_kind == SharedProcess)
+        process = m_processes.empty() ? 0 : &m_processes.front();
+    else if (!site.empty())
+        process = findSite(site);
+    if (!process && m_processes.size() >= m_maxProcesses)
+        process = leastLoaded();
+
+    if (process)
+        ++m_sharedAssignments;
+    else {
+        Process newProcess = { Tab::createContext(), site, 0 };
+        m_processes.push_back(newProcess);
+        process = &m_processes.back();
+        ++m_processesCreated;
+    }
+
+    WKRetain(process->context);
+    return process->context;
+}
+
+void ProcessModel::didOpenTab(WKContextRef context)
+{
+    if (Process* process = find(context))
+        ++process->tabs;
+}
+
+void ProcessModel::didCloseTab(WKContextRef context)
+{
+    Process* process = find(context);
+    if (!process || --process->tabs)
+        return;
+
+    // The shared process is kept for the next tab, a site's one exits with its last page.
+    if (m_kind != ProcessPerSite)
+        return;
+    WKRelease(process->context);
+    m_processes.erase(m_processes.begin() + (process - &m_processes.front()));
+}
+
+void ProcessModel::didLoadUrl(WKContextRef context, const std::string& url)
+{
+    if (m_kind != ProcessPerSite)
+        return;
+
+    Process* process = find(context);
+    if (!process || !process->site.empty())
+        return;
+
+    std::string site = registrableDomain(url);
+    if (!site.empty() && !findSite(site))
+        process->site = site;
+}
+
+void ProcessModel::dumpStatistics(std::ostream& out) const
+{
+    static const char* kindNames[] = { "per tab", "shared", "per site" };
+    out << "Process model: " << kindNames[m_kind] << ", " << m_processesCreated << " processes created, ";
+    if (m_kind != ProcessPerTab)
+        out << m_processes.size() << " alive, ";
+    out << m_sharedAssignments << " tabs placed in an existing process" << std::endl;
+}
+
+std::string ProcessModel::registrableDomain(const std::string& url)
+{
+    size_t hostStart = 0;
+    size_t schemeEnd = url.find("://");
+    if (schemeEnd != std::string::npos) {
+        if (!url.compare(0, schemeEnd, "file"))
+            return std::string();
+        hostStart = schemeEnd + 3;
+    } else if (!url.compare(0, 6, "about:") || !url.compare(0, 5, "data:"))
+        return std::string();
+
+    size_t hostEnd = url.find_first_of("/?#", hostStart);
+    std::string host = url.substr(hostStart, hostEnd == std::string::npos ? std::string::npos : hostEnd - hostStart);
+    size_t userInfoEnd = host.rfind('@');
+    if (userInfoEnd != std::string::npos)
+        host.erase(0, userInfoEnd + 1);
+    if (!host.empty() && host[0] == '[')
+        return host.substr(0, host.find(']') + 1);
+    size_t portStart = host.find(':');
+    if (portStart != std::string::npos)
+        host.erase(portStart);
+    if (!host.empty() && host.back() == '.')
+        host.pop_back();
+    std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+
+    if (host.find_first_not_of("0123456789.") == std::string::npos)
+        return host;
+
+    size_t lastDot = host.rfind('.');
+    if (lastDot == std::string::npos || !lastDot)
+        return host;
+    size_t secondDot = host.rfind('.', lastDot - 1);
+    if (secondDot == std::string::npos)
+        return host;
+
+    // Without a public suffix list, the usual second levels under a country code are taken as
+    // part of the suffix.
+    static const char* secondLevels[] = { "ac", "co", "com", "edu", "gov", "ne", "net", "or", "org" };
+    bool countryCode = host.size() - lastDot - 1 == 2;
+    std::string secondLevel = host.substr(secondDot + 1, lastDot - secondDot - 1);
+    bool isSuffix = std::find(std::begin(secondLevels), std::end(secondLevels), secondLevel) != std::end(secondLevels);
+    if (countryCode && isSuffix && secondDot) {
+        size_t thirdDot = host.rfind('.', secondDot - 1);
+        return thirdDot == std::string::npos ? host : host.substr(thirdDot + 1);
+    }
+    return host.substr(secondDot + 1);
+}
+
+ProcessModel::Process* ProcessModel::find(WKContextRef context)
+{
+    for (Process& process : m_processes) {
+        if (process.context == context)
+            return &process;
+    }
+    return 0;
+}
+
+ProcessModel::Process* ProcessModel::findSite(const std::string& site)
+{
+    for (Process& process : m_processes) {
+        if (process.site == site)
+            return &process;
+    }
+    return 0;
+}
+
+ProcessModel::Process* ProcessModel::leastLoaded()
+{
+    Process* least = 0;
+    for (Process& process : m_processes) {
+        if (!least || process.tabs < least->tabs)
+            least = &process;
+    }
+    return least;
+}
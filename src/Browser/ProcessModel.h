@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ProcessModel_h
+#define ProcessModel_h
+
+#include <WebKit2/WKContext.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Decides which WKContext, thus which web process, a new top-level tab runs in. Child tabs always
+// share the context of their opener, since they may script each other.
+class ProcessModel {
+public:
+    enum Kind {
+        // A web process per tab, the most isolated and the most memory hungry.
+        ProcessPerTab,
+        // A single web process for every tab.
+        SharedProcess,
+        // Tabs on the same registrable domain share a web process, up to a number of processes
+        // after which new sites go to the least loaded one.
+        ProcessPerSite
+    };
+
+    ProcessModel(Kind, unsigned maxProcesses);
+    ~ProcessModel();
+
+    Kind kind() const { return m_kind; }
+
+    // Context for a new top-level tab about to load the URL, which may be empty when it's blank.
+    // The caller owns the returned reference.
+    WKContextRef contextForUrl(const std::string& url);
+
+    void didOpenTab(WKContextRef);
+    void didCloseTab(WKContextRef);
+    // A tab opened blank gets a process of no site, which is given to the first site it loads.
+    void didLoadUrl(WKContextRef, const std::string& url);
+
+    void dumpStatistics(std::ostream&) const;
+
+    // Last two labels of the host, or three for second level suffixes like co.uk. Hosts which are
+    // IP addresses are kept whole, and URLs without a host give an empty string.
+    static std::string registrableDomain(const std::string& url);
+
+private:
+    struct Process {
+        WKContextRef context;
+        std::string site;
+        unsigned tabs;
+    };
+
+    Process* find(WKContextRef);
+    Process* findSite(const std::string& site);
+    Process* leastLoaded();
+
+    Kind m_kind;
+    unsigned m_maxProcesses;
+    // Not used when there's a process per tab, those go away with their tab.
+    std::vector<Process> m_processes;
+
+    unsigned m_processesCreated;
+    unsigned m_sharedAssignments;
+};
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ScreenshotCapturer.h"
+
+#include "MainLoopScheduling.h"
+#include <cairo.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct ScreenshotJob {
+    std::vector<unsigned char> pixels;
+    int width;
+    int height;
+    std::string fileName;
+    ScreenshotCapturer::Client* client;
+    bool saved;
+};
+
+}
+
+// Pixels are BGRA, bottom-up as GL reads them.
+static bool writePPM(const ScreenshotJob& job)
+{
+    FILE* file = fopen(job.fileName.c_str(), "wb");
+    if (!file)
+        return false;
+
+    fprintf(file, "P6\n%d %d\n255\n", job.width, job.height);
+    std::vector<unsigned char> row(job.width * 3);
+    for (int y = job.height - 1; y >= 0; --y) {
+        const unsigned char* pixel = &job.pixels[y * job.width * 4];
+        for (int x = 0; x < job.width; ++x, pixel += 4) {
+            row[x * 3] = pixel[2];
+            row[x * 3 + 1] = pixel[1];
+            row[x * 3 + 2] = pixel[0];
+        }
+        fwrite(&row[0], 1, row.size(), file);
+    }
+    return !fclose(file);
+}
+
+static bool writePNG(const ScreenshotJob& job)
+{
+    // RGB24 uses the same byte layout as GL_BGRA on little endian hosts, ignoring the alpha.
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, job.width);
+    std::vector<unsigned char> data(stride * job.height);
+    for (int y = 0; y < job.height; ++y)
+        memcpy(&data[y * stride], &job.pixels[(job.height - 1 - y) * job.width * 4], job.width * 4);
+
+    cairo_surface_t* surface = cairo_image_surface_create_for_data(&data[0], CAIRO_FORMAT_RGB24, job.width, job.height, stride);
+    bool saved = cairo_surface_write_to_png(surface, job.fileName.c_str()) == CAIRO_STATUS_SUCCESS;
+    cairo_surface_destroy(surface);
+    return saved;
+}
+
+static bool hasSuffix(const std::string& string, const char* suffix)
+{
+    size_t length = strlen(suffix);
+    return string.size() >= length && !string.compare(string.size() - length, length, suffix);
+}
+
+ScreenshotCapturer::ScreenshotCapturer(Client* client)
+    : m_client(client)
+    , m_nextReadback(0)
+    , m_jobs(g_async_queue_new())
+    , m_worker(g_thread_new("Screenshots", workerMain, m_jobs))
+{
+}
+
+ScreenshotCapturer::~ScreenshotCapturer()
+{
+    // A job without file name stops the worker once the queued ones are written.
+    ScreenshotJob* quit = new ScreenshotJob;
+    quit->client = 0;
+    g_async_queue_push(m_jobs, quit);
+    g_thread_join(m_worker);
+    g_async_queue_unref(m_jobs);
+}
+
+void ScreenshotCapturer::capture(GLuint framebuffer, const WKSize& size, const std::string& fileName)
+{
+    Readback& readback = m_readbacks[m_nextReadback];
+    m_nextReadback = (m_nextReadback + 1) % 2;
+
+    if (!readback.readback)
+        readback.readback = new GLReadback;
+    // Both buffers in flight, the oldest one has to be waited for.
+    else if (readback.readback->isPending())
+        finishReadback(readback);
+
+    readback.readback->start(framebuffer, size);
+    readback.fileName = fileName;
+}
+
+bool ScreenshotCapturer::hasPendingReadbacks() const
+{
+    for (unsigned i = 0; i < 2; ++i) {
+        if (m_readbacks[i].readback && m_readbacks[i].readback->isPending())
+            return true;
+    }
+    return false;
+}
+
+void ScreenshotCapturer::collect(bool wait)
+{
+    // Oldest first, so files get written in the order they were asked for.
+    for (unsigned i = 0; i < 2; ++i) {
+        Readback& readback = m_readbacks[(m_nextReadback + i) % 2];
+        if (!readback.readback || !readback.readback->isPending())
+            continue;
+        if (!wait && !readback.readback->isFinished())
+            return;
+        finishReadback(readback);
+    }
+}
+
+void ScreenshotCapturer::finishReadback(Readback& readback)
+{
+    ScreenshotJob* job = new ScreenshotJob;
+    job->width = readback.readback->size().width;
+    job->height = readback.readback->size().height;
+    job->fileName = readback.fileName;
+    job->client = m_client;
+    job->saved = false;
+
+    if (const unsigned char* pixels = readback.readback->map()) {
+        job->pixels.assign(pixels, pixels + job->width * job->height * 4);
+        readback.readback->unmap();
+    }
+
+    g_async_queue_push(m_jobs, job);
+}
+
+void ScreenshotCapturer::releaseGLResources()
+{
+    collect(true);
+    for (unsigned i = 0; i < 2; ++i) {
+        delete m_readbacks[i].readback;
+        m_readbacks[i].readback = 0;
+    }
+}
+
+gpointer ScreenshotCapturer::workerMain(gpointer data)
+{
+    GAsyncQueue* jobs = reinterpret_cast<GAsyncQueue*>(data);
+    while (true) {
+        ScreenshotJob* job = reinterpret_cast<ScreenshotJob*>(g_async_queue_pop(jobs));
+        if (job->fileName.empty()) {
+            delete job;
+            break;
+        }
+
+        if (!job->pixels.empty())
+            job->saved = hasSuffix(job->fileName, ".ppm") ? writePPM(*job) : writePNG(*job);
+        if (!job->saved)
+            std::cerr << "Could not save screenshot to " << job->fileName << std::endl;
+
+        std::vector<unsigned char>().swap(job->pixels);
+        scheduleIdle(BookkeepingClass, [](gpointer data) -> gboolean {
+            ScreenshotJob* job = reinterpret_cast<ScreenshotJob*>(data);
+            job->client->didSaveScreenshot(job->fileName, job->saved);
+            delete job;
+            return false;
+        }, job);
+    }
+    return 0;
+}
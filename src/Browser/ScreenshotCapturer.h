@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ScreenshotCapturer_h
+#define ScreenshotCapturer_h
+
+#include "GLReadback.h"
+#include <glib.h>
+#include <string>
+
+// Saves frames to PNG, or PPM when the file name ends with ".ppm", without stalling painting.
+// Frames are read back through two alternating GLReadbacks, mapped once finished, usually by the
+// following frame, and encoded on a worker thread. Everything but the client notifications runs
+// on the GL thread.
+class ScreenshotCapturer {
+public:
+    class Client {
+    public:
+        // Called on the main thread once the file is written.
+        virtual void didSaveScreenshot(const std::string& fileName, bool saved) = 0;
+    };
+
+    ScreenshotCapturer(Client*);
+    ~ScreenshotCapturer();
+
+    void capture(GLuint framebuffer, const WKSize&, const std::string& fileName);
+    bool hasPendingReadbacks() const;
+    // Hands finished readbacks to the worker, waiting for the unfinished ones if asked to.
+    void collect(bool wait);
+    void releaseGLResources();
+
+private:
+    struct Readback {
+        Readback() : readback(0) { }
+
+        GLReadback* readback;
+        std::string fileName;
+    };
+
+    void finishReadback(Readback&);
+    static gpointer workerMain(gpointer);
+
+    Client* m_client;
+    Readback m_readbacks[2];
+    unsigned m_nextReadback;
+    GAsyncQueue* m_jobs;
+    GThread* m_worker;
+};
+
+#endif
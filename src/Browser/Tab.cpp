@@ -28,7 +28,9 @@
 #include <fstream>
 #include <cassert>
 #include <cstring>
+#include <WebKit2/WKBackForwardList.h>
 #include <WebKit2/WKContext.h>
+#include <WebKit2/WKData.h>
 #include <WebKit2/WKError.h>
 #include <WebKit2/WKNumber.h>
 #include <WebKit2/WKPage.h>
@@ -38,26 +40,68 @@
 #include <WebKit2/WKURLRequest.h>
 #include <WebKit2/WKType.h>
 #include <WebKit2/WKHitTestResult.h>
+#include <glib.h>
 #include "Browser.h"
 #include "InjectedBundleGlue.h"
 
 static int nextTabId = 0;
 
-Tab::Tab(Browser* browser)
-    : m_id(nextTabId++)
-    , m_browser(browser)
+WKContextRef Tab::createContext()
 {
     // FIXME Find a good way to find where the injected bundle is
     WKStringRef wkStr = WKStringCreateWithUTF8CString((getApplicationPath() + "/../ContentsInjectedBundle/libPageBundle.so").c_str());
-    m_context = WKContextCreateWithInjectedBundlePath(wkStr);
+    WKContextRef context = WKContextCreateWithInjectedBundlePath(wkStr);
     WKRelease(wkStr);
+    return context;
+}
+
+Tab::Tab(Browser* browser, WKContextRef context)
+    : m_id(nextTabId++)
+    , m_browser(browser)
+    , m_view(0)
+    , m_context(context)
+    , m_sessionState(0)
+    , m_lastVisibilityChange(g_get_monotonic_time())
+    , m_visible(false)
+    , m_size(WKSizeMake(0, 0))
+    , m_viewportTranslation(WKPointMake(0, 0))
+    , m_sizeApplied(false)
+    , m_geometryChanged(false)
+    , m_pooled(false)
+{
+    init();
+}
+
+Tab::Tab(Browser* browser, WKContextRef context, WKViewRef view)
+    : m_id(nextTabId++)
+    , m_browser(browser)
+    , m_view(view)
+    , m_context(context)
+    , m_sessionState(0)
+    , m_lastVisibilityChange(g_get_monotonic_time())
+    , m_visible(false)
+    , m_size(WKSizeMake(0, 0))
+    , m_viewportTranslation(WKPointMake(0, 0))
+    , m_sizeApplied(false)
+    , m_geometryChanged(false)
+    , m_pooled(true)
+{
     init();
 }
 
 Tab::Tab(Tab* parent)
     : m_id(nextTabId++)
     , m_browser(parent->m_browser)
+    , m_view(0)
     , m_context(parent->m_context)
+    , m_sessionState(0)
+    , m_lastVisibilityChange(g_get_monotonic_time())
+    , m_visible(false)
+    , m_size(WKSizeMake(0, 0))
+    , m_viewportTranslation(WKPointMake(0, 0))
+    , m_sizeApplied(false)
+    , m_geometryChanged(false)
+    , m_pooled(false)
 {
     WKRetain(m_context);
     init();
@@ -66,8 +110,10 @@ Tab::Tab(Tab* parent)
 
 void Tab::init()
 {
-    m_view = WKViewCreate(m_context, m_browser->contentPageGroup());
-    WKViewInitialize(m_view);
+    if (!m_view) {
+        m_view = WKViewCreate(m_context, m_browser->contentPageGroup());
+        WKViewInitialize(m_view);
+    }
     WKViewSetIsFocused(m_view, true);
     WKViewSetIsVisible(m_view, true);
     m_page = WKViewGetPage(m_view);
@@ -114,10 +160,37 @@ void Tab::init()
 
 Tab::~Tab()
 {
-    WKPageClose(m_page);
+    if (m_view) {
+        WKPageClose(m_page);
+        WKRelease(m_view);
+    }
+    if (m_sessionState)
+        WKRelease(m_sessionState);
     WKRelease(m_context);
+}
 
+void Tab::discard()
+{
+    assert(!isDiscarded());
+    // The back/forward list items keep their scroll positions and form state.
+    m_sessionState = WKPageCopySessionState(m_page, 0, 0);
+    WKPageClose(m_page);
     WKRelease(m_view);
+    m_view = 0;
+    m_page = 0;
+    m_damage.clear();
+}
+
+void Tab::restore()
+{
+    assert(isDiscarded());
+    init();
+    updateGeometry();
+    if (m_sessionState) {
+        WKPageRestoreFromSessionState(m_page, m_sessionState);
+        WKRelease(m_sessionState);
+        m_sessionState = 0;
+    }
 }
 
 void Tab::onStartProgressCallback(WKPageRef, const void* clientInfo)
@@ -136,6 +209,7 @@ void Tab::onFinishProgressCallback(WKPageRef, const void* clientInfo)
 {
     Tab* self = ((Tab*)clientInfo);
     postToBundle(self->m_browser->ui(), "progressFinished", self->m_id);
+    self->m_browser->tabLoadFinished(self);
 }
 
 void Tab::onCommitLoadForFrame(WKPageRef page, WKFrameRef frame, WKTypeRef, const void *clientInfo)
@@ -147,7 +221,14 @@ void Tab::onCommitLoadForFrame(WKPageRef page, WKFrameRef frame, WKTypeRef, cons
 
     WKURLRef url = WKPageCopyActiveURL(page);
     WKStringRef urlString = WKURLCopyString(url);
-    postToBundle(self->m_browser->ui(), "urlChanged", self->m_id, urlString);
+    if (!self->m_pooled || !WKStringIsEqualToUTF8CString(urlString, "about:blank")) {
+        if (self->m_pooled) {
+            // Going back from the first page must not lead to the warm-up one.
+            WKBackForwardListClear(WKPageGetBackForwardList(page));
+            self->m_pooled = false;
+        }
+        postToBundle(self->m_browser->ui(), "urlChanged", self->m_id, urlString);
+    }
     WKRelease(url);
     WKRelease(urlString);
 }
@@ -158,10 +239,13 @@ void Tab::onMouseCursorChanged(WKViewRef, unsigned int shape, const void* client
     self->m_browser->window()->setMouseCursor(shape);
 }
 
-void Tab::onViewNeedsDisplayCallback(WKViewRef, WKRect, const void* clientInfo)
+void Tab::onViewNeedsDisplayCallback(WKViewRef, WKRect rect, const void* clientInfo)
 {
     Tab* self = ((Tab*)clientInfo);
-    // FIXME: Only do this is the tab is visible!
+    // Switching to a tab drops its damage anyway and waits for it to repaint.
+    if (!self->m_visible)
+        return;
+    self->m_damage.add(rect);
     self->m_browser->scheduleUpdateDisplay();
 }
 
@@ -201,7 +285,12 @@ WKPageRef Tab::createNewPageCallback(WKPageRef, WKURLRequestRef, WKDictionaryRef
 
 void Tab::setSize(WKSize size)
 {
-    WKViewSetSize(m_view, size);
+    m_size = size;
+    // The page needs a size to lay out while it loads, later changes wait until it's shown.
+    if (m_visible || !m_sizeApplied)
+        updateGeometry();
+    else
+        m_geometryChanged = true;
 }
 
 void Tab::sendKeyEvent(NIXKeyEvent* event)
@@ -223,12 +312,38 @@ void Tab::sendMouseEvent<NIXMouseEvent*>(NIXMouseEvent* event)
 
 void Tab::setViewportTranslation(int left, int top)
 {
-    WKViewSetUserViewportTranslation(m_view, left, top);
+    m_viewportTranslation = WKPointMake(left, top);
+    if (m_visible)
+        updateGeometry();
+    else
+        m_geometryChanged = true;
+}
+
+void Tab::updateGeometry()
+{
+    m_geometryChanged = false;
+    if (!m_view)
+        return;
+    WKViewSetSize(m_view, m_size);
+    WKViewSetUserViewportTranslation(m_view, m_viewportTranslation.x, m_viewportTranslation.y);
+    m_sizeApplied = true;
 }
 
 void Tab::setVisibility(WKPageVisibilityState state)
 {
-    WKPageSetVisibilityState(m_page, state, false);
+    m_lastVisibilityChange = g_get_monotonic_time();
+    m_visible = state == kWKPageVisibilityStateVisible;
+    if (m_visible && m_geometryChanged)
+        updateGeometry();
+    if (m_page)
+        WKPageSetVisibilityState(m_page, state, false);
+}
+
+Damage Tab::takeDamage()
+{
+    Damage damage = m_damage;
+    m_damage.clear();
+    return damage;
 }
 
 static bool hasValidPrefix(const std::string& url)
@@ -27,8 +27,10 @@
 #define Tab_h
 
 #include <string>
+#include <cstdint>
 #include <functional>
 #include <NIXView.h>
+#include "Damage.h"
 #include <WebKit2/WKContext.h>
 #include <WebKit2/WKPageVisibilityTypes.h>
 
@@ -36,14 +38,30 @@ class Browser;
 
 class Tab {
 public:
-    Tab(Browser* browser);
+    // Adopts the context, as handed out by ProcessModel.
+    Tab(Browser* browser, WKContextRef);
+    // Adopts a view already created, with its context, as TabPool hands them out.
+    Tab(Browser* browser, WKContextRef, WKViewRef);
     Tab(Tab* parent);
     ~Tab();
 
+    // Context of a new web process, running the contents injected bundle.
+    static WKContextRef createContext();
+
     int id() const { return m_id; }
+    WKContextRef context() const { return m_context; }
+    // Monotonic time the tab was last shown or hidden, or created.
+    int64_t lastVisibilityChange() const { return m_lastVisibilityChange; }
+
+    // Closes the page, keeping only its session state, from which the tab is restored before it's
+    // shown again. A discarded tab has no view, size and viewport changes wait for its restoration.
+    void discard();
+    void restore();
+    bool isDiscarded() const { return !m_view; }
 
     // temporary method while things is changing
     WKViewRef webView() { return m_view; }
+    // Only applied while the tab is visible, hidden tabs get the latest ones when they are shown.
     void setSize(WKSize);
     void sendKeyEvent(NIXKeyEvent*);
     template<typename T>
@@ -52,6 +70,9 @@ public:
     void setViewportTranslation(int left, int top);
     void setVisibility(WKPageVisibilityState);
 
+    // Returns the area of the view that needs repainting since the last call, in view coordinates.
+    Damage takeDamage();
+
     void loadUrl(const std::string& url);
     void back();
     void forward();
@@ -63,8 +84,20 @@ private:
     WKViewRef m_view;
     WKPageRef m_page;
     WKContextRef m_context;
+    WKDataRef m_sessionState;
+    int64_t m_lastVisibilityChange;
+    bool m_visible;
+    WKSize m_size;
+    WKPoint m_viewportTranslation;
+    bool m_sizeApplied;
+    bool m_geometryChanged;
+    // The view came from TabPool and no page replaced its blank warm-up one yet, which is kept out
+    // of the URL bar and of the history.
+    bool m_pooled;
+    Damage m_damage;
 
     void init();
+    void updateGeometry();
 
     static void onMouseCursorChanged(WKViewRef, unsigned, const void* clientInfo);
 
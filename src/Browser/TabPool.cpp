@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TabPool.h"
+
+#include "MainLoopScheduling.h"
+#include "Tab.h"
+#include <WebKit2/WKFrame.h>
+#include <WebKit2/WKPage.h>
+#include <WebKit2/WKURL.h>
+#include <cstring>
+
+TabPool::TabPool(WKPageGroupRef pageGroup, unsigned capacity)
+    : m_pageGroup(pageGroup)
+    , m_capacity(capacity)
+    , m_refillSource(0)
+    , m_started(false)
+    , m_hits(0)
+    , m_warmingHits(0)
+    , m_misses(0)
+{
+    WKRetain(m_pageGroup);
+}
+
+TabPool::~TabPool()
+{
+    if (m_refillSource)
+        g_source_remove(m_refillSource);
+
+    for (Entry* entry : m_entries) {
+        WKPageClose(WKViewGetPage(entry->view));
+        WKRelease(entry->view);
+        WKRelease(entry->context);
+        delete entry;
+    }
+    WKRelease(m_pageGroup);
+}
+
+bool TabPool::take(WKContextRef& context, WKViewRef& view)
+{
+    if (m_entries.empty()) {
+        if (m_started)
+            ++m_misses;
+        return false;
+    }
+
+    // The oldest entry is the most likely to be ready.
+    Entry* entry = m_entries.front();
+    m_entries.erase(m_entries.begin());
+    if (entry->committed)
+        ++m_hits;
+    else
+        ++m_warmingHits;
+
+    context = entry->context;
+    view = entry->view;
+    delete entry;
+    return true;
+}
+
+void TabPool::scheduleRefill()
+{
+    m_started = true;
+    if (m_refillSource || m_entries.size() >= m_capacity)
+        return;
+    m_refillSource = scheduleIdle(BackgroundClass, refillCallback, this);
+}
+
+gboolean TabPool::refillCallback(gpointer data)
+{
+    // One process launch per idle callback, so the main loop stays responsive meanwhile.
+    TabPool* self = reinterpret_cast<TabPool*>(data);
+    self->addEntry();
+    if (self->m_entries.size() < self->m_capacity)
+        return true;
+    self->m_refillSource = 0;
+    return false;
+}
+
+void TabPool::addEntry()
+{
+    Entry* entry = new Entry;
+    entry->context = Tab::createContext();
+    entry->view = WKViewCreate(entry->context, m_pageGroup);
+    entry->committed = false;
+    WKViewInitialize(entry->view);
+
+    WKPageRef page = WKViewGetPage(entry->view);
+    WKPageSetVisibilityState(page, kWKPageVisibilityStateHidden, true);
+
+    // Replaced by the tab taking the view.
+    WKPageLoaderClientV3 loaderClient;
+    memset(&loaderClient, 0, sizeof(WKPageLoaderClientV3));
+    loaderClient.base.version = 3;
+    loaderClient.base.clientInfo = entry;
+    loaderClient.didCommitLoadForFrame = &TabPool::onCommitLoadForFrame;
+    WKPageSetPageLoaderClient(page, &loaderClient.base);
+
+    // Loading anything launches the web process.
+    WKURLRef blank = WKURLCreateWithUTF8CString("about:blank");
+    WKPageLoadURL(page, blank);
+    WKRelease(blank);
+
+    m_entries.push_back(entry);
+}
+
+void TabPool::onCommitLoadForFrame(WKPageRef, WKFrameRef frame, WKTypeRef, const void* clientInfo)
+{
+    if (WKFrameIsMainFrame(frame))
+        reinterpret_cast<Entry*>(const_cast<void*>(clientInfo))->committed = true;
+}
+
+void TabPool::dumpStatistics(std::ostream& out) const
+{
+    out << "Tab pool: " << m_entries.size() << " of " << m_capacity << " warm, "
+        << m_hits << " hits, " << m_warmingHits << " hits still warming, "
+        << m_misses << " misses" << std::endl;
+}
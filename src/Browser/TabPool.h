@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TabPool_h
+#define TabPool_h
+
+#include <WebKit2/WKContext.h>
+#include <NIXView.h>
+#include <glib.h>
+#include <ostream>
+#include <vector>
+
+// Every top-level tab gets a web process of its own, which has to launch, load the injected bundle
+// and initialize the platform before anything can load. The pool keeps some of them warm, each
+// with a hidden view on a committed blank page, and refills itself in idle time.
+class TabPool {
+public:
+    TabPool(WKPageGroupRef, unsigned capacity);
+    ~TabPool();
+
+    // Hands a warm view and its context over to the caller, who releases them. Returns false when
+    // the pool is empty.
+    bool take(WKContextRef&, WKViewRef&);
+    void scheduleRefill();
+
+    void dumpStatistics(std::ostream&) const;
+
+private:
+    struct Entry {
+        WKContextRef context;
+        WKViewRef view;
+        bool committed;
+    };
+
+    static gboolean refillCallback(gpointer);
+    static void onCommitLoadForFrame(WKPageRef, WKFrameRef, WKTypeRef, const void* clientInfo);
+    void addEntry();
+
+    WKPageGroupRef m_pageGroup;
+    unsigned m_capacity;
+    std::vector<Entry*> m_entries;
+    guint m_refillSource;
+    // Tabs taken before the pool first started filling, like the startup ones, aren't misses.
+    bool m_started;
+
+    unsigned m_hits;
+    unsigned m_warmingHits;
+    unsigned m_misses;
+};
+
+#endif
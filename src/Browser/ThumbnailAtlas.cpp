@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ThumbnailAtlas.h"
+
+#include "GLFramebuffer.h"
+#include <algorithm>
+
+static const int slotWidth = 256;
+static const int slotHeight = 160;
+static const unsigned atlasColumns = 4;
+static const int bytesPerPixel = 4;
+
+ThumbnailAtlas::ThumbnailAtlas(size_t memoryCap)
+    : m_texture(0)
+    , m_columns(atlasColumns)
+    , m_rows(std::max<size_t>(1, memoryCap / (atlasColumns * slotWidth * slotHeight * bytesPerPixel)))
+    , m_slotTabs(m_columns * m_rows, -1)
+    , m_slotLastUse(m_columns * m_rows, 0)
+    , m_useCount(0)
+    , m_evictions(0)
+{
+}
+
+ThumbnailAtlas::~ThumbnailAtlas()
+{
+    delete m_texture;
+    for (const std::pair<const int, GLFramebuffer*>& kept : m_keptThumbnails)
+        delete kept.second;
+}
+
+WKRect ThumbnailAtlas::slotRect(size_t slot) const
+{
+    return WKRectMake((slot % m_columns) * slotWidth, (slot / m_columns) * slotHeight, slotWidth, slotHeight);
+}
+
+size_t ThumbnailAtlas::takeSlot(int tabId)
+{
+    std::map<int, size_t>::iterator it = m_tabSlots.find(tabId);
+    if (it != m_tabSlots.end())
+        return it->second;
+
+    size_t slot = std::min_element(m_slotLastUse.begin(), m_slotLastUse.end()) - m_slotLastUse.begin();
+    if (m_slotTabs[slot] != -1) {
+        m_tabSlots.erase(m_slotTabs[slot]);
+        ++m_evictions;
+    }
+    m_slotTabs[slot] = tabId;
+    m_tabSlots[tabId] = slot;
+    return slot;
+}
+
+void ThumbnailAtlas::store(int tabId, unsigned framebuffer, const WKRect& rect, int framebufferHeight)
+{
+    if (!m_texture) {
+        m_texture = new GLFramebuffer;
+        m_texture->resize(WKSizeMake(m_columns * slotWidth, m_rows * slotHeight));
+    }
+    if (!m_texture->isComplete() || rect.size.width <= 0 || rect.size.height <= 0)
+        return;
+
+    dropKept(tabId);
+    size_t slot = takeSlot(tabId);
+    m_slotLastUse[slot] = ++m_useCount;
+    GLFramebuffer::blit(framebuffer, rect, framebufferHeight, m_texture->id(), slotRect(slot), m_texture->size().height);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+bool ThumbnailAtlas::draw(int tabId, unsigned framebuffer, const WKRect& rect, int framebufferHeight)
+{
+    std::map<int, GLFramebuffer*>::iterator kept = m_keptThumbnails.find(tabId);
+    if (kept != m_keptThumbnails.end()) {
+        GLFramebuffer::blit(kept->second->id(), WKRectMake(0, 0, slotWidth, slotHeight), slotHeight, framebuffer, rect, framebufferHeight);
+        return true;
+    }
+
+    std::map<int, size_t>::iterator it = m_tabSlots.find(tabId);
+    if (it == m_tabSlots.end() || !m_texture)
+        return false;
+
+    m_slotLastUse[it->second] = ++m_useCount;
+    GLFramebuffer::blit(m_texture->id(), slotRect(it->second), m_texture->size().height, framebuffer, rect, framebufferHeight);
+    return true;
+}
+
+void ThumbnailAtlas::keep(int tabId, unsigned framebuffer)
+{
+    std::map<int, size_t>::iterator it = m_tabSlots.find(tabId);
+    if (it == m_tabSlots.end() || !m_texture)
+        return;
+
+    GLFramebuffer* thumbnail = new GLFramebuffer;
+    thumbnail->resize(WKSizeMake(slotWidth, slotHeight));
+    if (!thumbnail->isComplete()) {
+        delete thumbnail;
+        return;
+    }
+    GLFramebuffer::blit(m_texture->id(), slotRect(it->second), m_texture->size().height, thumbnail->id(), WKRectMake(0, 0, slotWidth, slotHeight), slotHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    dropKept(tabId);
+    m_keptThumbnails[tabId] = thumbnail;
+    // Its slot is free for the tabs still able to refresh theirs.
+    freeSlot(tabId);
+}
+
+void ThumbnailAtlas::dropKept(int tabId)
+{
+    std::map<int, GLFramebuffer*>::iterator it = m_keptThumbnails.find(tabId);
+    if (it == m_keptThumbnails.end())
+        return;
+    delete it->second;
+    m_keptThumbnails.erase(it);
+}
+
+void ThumbnailAtlas::remove(int tabId)
+{
+    dropKept(tabId);
+    freeSlot(tabId);
+}
+
+void ThumbnailAtlas::freeSlot(int tabId)
+{
+    std::map<int, size_t>::iterator it = m_tabSlots.find(tabId);
+    if (it == m_tabSlots.end())
+        return;
+
+    m_slotTabs[it->second] = -1;
+    m_slotLastUse[it->second] = 0;
+    m_tabSlots.erase(it);
+}
+
+void ThumbnailAtlas::releaseGLResources()
+{
+    delete m_texture;
+    m_texture = 0;
+    for (const std::pair<const int, GLFramebuffer*>& kept : m_keptThumbnails)
+        delete kept.second;
+    m_keptThumbnails.clear();
+    m_tabSlots.clear();
+    std::fill(m_slotTabs.begin(), m_slotTabs.end(), -1);
+    std::fill(m_slotLastUse.begin(), m_slotLastUse.end(), 0);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ThumbnailAtlas_h
+#define ThumbnailAtlas_h
+
+#include <WebKit2/WKGeometry.h>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+class GLFramebuffer;
+
+// Downscaled snapshots of the tabs, packed into a single texture whose size is bounded by the
+// memory cap given. When it's full, the least recently used thumbnail makes room for the new one.
+// Thumbnails kept aside with keep() are out of the atlas and never evicted. Only used from the thread owning the GL context.
+class ThumbnailAtlas {
+public:
+    explicit ThumbnailAtlas(size_t memoryCap);
+    ~ThumbnailAtlas();
+
+    // Stores a rect of the framebuffer, in top-left based coordinates, as the tab thumbnail.
+    void store(int tabId, unsigned framebuffer, const WKRect&, int framebufferHeight);
+    // Scales the tab thumbnail up to a rect of the framebuffer, returns false if it has none.
+    bool draw(int tabId, unsigned framebuffer, const WKRect&, int framebufferHeight);
+    // Moves the tab thumbnail out of the atlas into a texture of its own, which is never evicted,
+    // for tabs that can't be snapshotted again. Leaves the framebuffer given bound.
+    void keep(int tabId, unsigned framebuffer);
+    // Drops the thumbnail, kept or not.
+    void remove(int tabId);
+
+    size_t capacity() const { return m_slotLastUse.size(); }
+    size_t size() const { return m_tabSlots.size(); }
+    size_t kept() const { return m_keptThumbnails.size(); }
+    unsigned evictions() const { return m_evictions; }
+
+    void releaseGLResources();
+
+private:
+    WKRect slotRect(size_t slot) const;
+    size_t takeSlot(int tabId);
+    void freeSlot(int tabId);
+    void dropKept(int tabId);
+
+    GLFramebuffer* m_texture;
+    unsigned m_columns;
+    unsigned m_rows;
+
+    std::map<int, size_t> m_tabSlots;
+    std::vector<int> m_slotTabs;
+    std::vector<unsigned> m_slotLastUse;
+    unsigned m_useCount;
+    unsigned m_evictions;
+    std::map<int, GLFramebuffer*> m_keptThumbnails;
+};
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "VideoRecorder.h"
+
+#include "GLReadback.h"
+#include <cstring>
+#include <gst/app/gstappsrc.h>
+#include <iostream>
+
+// Frames waiting in appsrc beyond this are dropped rather than queued.
+static const unsigned maxQueuedFrames = 4;
+static const int recordingFrameRate = 30;
+
+static bool hasSuffix(const std::string& string, const char* suffix)
+{
+    size_t length = strlen(suffix);
+    return string.size() >= length && !string.compare(string.size() - length, length, suffix);
+}
+
+VideoRecorder::VideoRecorder(const std::string& fileName)
+    : m_fileName(fileName)
+    , m_pipeline(0)
+    , m_source(0)
+    , m_sourceSize(WKSizeMake(0, 0))
+    , m_failed(false)
+    , m_nextReadback(0)
+    , m_startTime(0)
+    , m_framesRecorded(0)
+    , m_framesDropped(0)
+{
+    if (!gst_is_initialized())
+        gst_init(0, 0);
+    m_readbacks[0] = m_readbacks[1] = 0;
+    m_readbackTimes[0] = m_readbackTimes[1] = 0;
+}
+
+VideoRecorder::~VideoRecorder()
+{
+    if (!m_pipeline)
+        return;
+
+    // Let the muxer write its headers and index before closing the file.
+    gst_app_src_end_of_stream(GST_APP_SRC(m_source));
+    GstBus* bus = gst_element_get_bus(m_pipeline);
+    if (GstMessage* message = gst_bus_timed_pop_filtered(bus, 5 * GST_SECOND, GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR)))
+        gst_message_unref(message);
+    gst_object_unref(bus);
+
+    gst_element_set_state(m_pipeline, GST_STATE_NULL);
+    gst_object_unref(m_source);
+    gst_object_unref(m_pipeline);
+    std::cerr << "Recorded " << m_framesRecorded << " frames to " << m_fileName << ", dropped " << m_framesDropped << std::endl;
+}
+
+bool VideoRecorder::createPipeline(const WKSize& size)
+{
+    // GL rows are bottom-up, the flip and the color conversion run on the streaming threads. Size
+    // changes are scaled to the size the recording started with, encoders can't cope with them.
+    const char* encoder = hasSuffix(m_fileName, ".mp4")
+        ? "x264enc tune=zerolatency speed-preset=ultrafast ! mp4mux"
+        : "vp8enc deadline=1 cpu-used=8 ! webmmux";
+    gchar* description = g_strdup_printf("appsrc name=source is-live=true format=time"
+        " ! queue leaky=downstream max-size-buffers=%u max-size-bytes=0 max-size-time=0"
+        " ! videoflip method=vertical-flip ! videoconvert ! videoscale ! videorate"
+        " ! video/x-raw,width=%d,height=%d,framerate=%d/1 ! %s ! filesink name=sink",
+        maxQueuedFrames, int(size.width), int(size.height), recordingFrameRate, encoder);
+
+    GError* error = 0;
+    m_pipeline = gst_parse_launch(description, &error);
+    g_free(description);
+    if (error) {
+        std::cerr << "Could not create the recording pipeline: " << error->message << std::endl;
+        g_error_free(error);
+        if (m_pipeline)
+            gst_object_unref(m_pipeline);
+        m_pipeline = 0;
+        return false;
+    }
+
+    GstElement* sink = gst_bin_get_by_name(GST_BIN(m_pipeline), "sink");
+    g_object_set(sink, "location", m_fileName.c_str(), NULL);
+    gst_object_unref(sink);
+
+    m_source = gst_bin_get_by_name(GST_BIN(m_pipeline), "source");
+    gst_element_set_state(m_pipeline, GST_STATE_PLAYING);
+    return true;
+}
+
+void VideoRecorder::recordFrame(unsigned framebuffer, const WKSize& size)
+{
+    if (m_failed)
+        return;
+
+    gint64 now = g_get_monotonic_time();
+    GLReadback*& readback = m_readbacks[m_nextReadback];
+    if (!readback)
+        readback = new GLReadback;
+    else if (readback->isPending()) {
+        // The frame before the previous one is still being read back, better skip this one.
+        if (!readback->isFinished()) {
+            ++m_framesDropped;
+            return;
+        }
+        pushFrame(*readback, m_readbackTimes[m_nextReadback]);
+    }
+
+    readback->start(framebuffer, size);
+    m_readbackTimes[m_nextReadback] = now;
+    m_nextReadback = (m_nextReadback + 1) % 2;
+}
+
+bool VideoRecorder::hasPendingReadbacks() const
+{
+    for (unsigned i = 0; i < 2; ++i) {
+        if (m_readbacks[i] && m_readbacks[i]->isPending())
+            return true;
+    }
+    return false;
+}
+
+void VideoRecorder::collect(bool wait)
+{
+    for (unsigned i = 0; i < 2; ++i) {
+        unsigned index = (m_nextReadback + i) % 2;
+        GLReadback* readback = m_readbacks[index];
+        if (!readback || !readback->isPending())
+            continue;
+        if (!wait && !readback->isFinished())
+            return;
+        pushFrame(*readback, m_readbackTimes[index]);
+    }
+}
+
+void VideoRecorder::pushFrame(GLReadback& readback, gint64 time)
+{
+    WKSize size = readback.size();
+    if (!m_pipeline && !createPipeline(size)) {
+        m_failed = true;
+        if (readback.map())
+            readback.unmap();
+        return;
+    }
+
+    if (size.width != m_sourceSize.width || size.height != m_sourceSize.height) {
+        GstCaps* caps = gst_caps_new_simple("video/x-raw",
+            "format", G_TYPE_STRING, "BGRx",
+            "width", G_TYPE_INT, int(size.width),
+            "height", G_TYPE_INT, int(size.height),
+            "framerate", GST_TYPE_FRACTION, 0, 1,
+            NULL);
+        gst_app_src_set_caps(GST_APP_SRC(m_source), caps);
+        gst_caps_unref(caps);
+        m_sourceSize = size;
+    }
+
+    gsize frameSize = size.width * size.height * 4;
+    const unsigned char* pixels = readback.map();
+    if (!pixels) {
+        ++m_framesDropped;
+        return;
+    }
+
+    // The encoder is behind, and the leaky queue after appsrc couldn't keep up either.
+    if (gst_app_src_get_current_level_bytes(GST_APP_SRC(m_source)) >= maxQueuedFrames * frameSize) {
+        readback.unmap();
+        ++m_framesDropped;
+        return;
+    }
+
+    GstBuffer* buffer = gst_buffer_new_allocate(0, frameSize, 0);
+    gst_buffer_fill(buffer, 0, pixels, frameSize);
+    readback.unmap();
+
+    if (!m_startTime)
+        m_startTime = time;
+    GST_BUFFER_PTS(buffer) = (time - m_startTime) * GST_USECOND;
+    gst_app_src_push_buffer(GST_APP_SRC(m_source), buffer);
+    ++m_framesRecorded;
+}
+
+void VideoRecorder::releaseGLResources()
+{
+    collect(true);
+    for (unsigned i = 0; i < 2; ++i) {
+        delete m_readbacks[i];
+        m_readbacks[i] = 0;
+    }
+}
+
+void VideoRecorder::dumpStatistics(std::ostream& out) const
+{
+    out << "Recording to " << m_fileName << ": " << m_framesRecorded << " frames recorded, "
+        << m_framesDropped << " dropped" << std::endl;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VideoRecorder_h
+#define VideoRecorder_h
+
+#include <WebKit2/WKGeometry.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <ostream>
+#include <string>
+
+class GLReadback;
+
+// Records the composed frames into a VP8/WebM file, or H.264/MP4 when the file name ends with
+// ".mp4". Frames are read back asynchronously and pushed into a GStreamer pipeline, which
+// converts and encodes them on its own threads. Frames are dropped whenever the readback or the
+// encoder falls behind, painting never waits for them. Only used from the thread owning the GL
+// context, besides construction.
+class VideoRecorder {
+public:
+    explicit VideoRecorder(const std::string& fileName);
+    // Finishes the file, the GL resources must have been released.
+    ~VideoRecorder();
+
+    void recordFrame(unsigned framebuffer, const WKSize&);
+    bool hasPendingReadbacks() const;
+    // Pushes the finished readbacks to the encoder, waiting for the unfinished ones if asked to.
+    void collect(bool wait);
+    void releaseGLResources();
+
+    void dumpStatistics(std::ostream&) const;
+
+private:
+    bool createPipeline(const WKSize&);
+    void pushFrame(GLReadback&, gint64 time);
+
+    std::string m_fileName;
+    GstElement* m_pipeline;
+    GstElement* m_source;
+    WKSize m_sourceSize;
+    bool m_failed;
+
+    GLReadback* m_readbacks[2];
+    gint64 m_readbackTimes[2];
+    unsigned m_nextReadback;
+    gint64 m_startTime;
+
+    unsigned m_framesRecorded;
+    unsigned m_framesDropped;
+};
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DesktopWindow.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <iostream>
+
+#include "FatalError.h"
+#include "GLFramebuffer.h"
+
+// Renders into an offscreen framebuffer without any display server. The context is bound with no
+// surface when EGL_KHR_surfaceless_context is available, and to a dummy pbuffer otherwise.
+class DesktopWindowEGL : public DesktopWindow {
+public:
+    DesktopWindowEGL(DesktopWindowClient* client, int width, int height);
+    ~DesktopWindowEGL();
+    void makeCurrent();
+    void doneCurrent();
+    void beginFrame(const WKSize&);
+    unsigned framebuffer();
+    const char* presentationMethod() const;
+    int bufferAge();
+    void swapBuffers(const WKRect& damagedRect);
+    void setMouseCursor(unsigned) { }
+    void setVisible(bool visible) { m_visible = visible; }
+    bool visible() const { return m_visible; }
+    void setPosition(const WKPoint&) { }
+    void setSize(const WKSize&);
+
+private:
+    void setup();
+    void freeResources();
+    EGLDisplay openDisplay();
+
+    EGLDisplay m_display;
+    EGLContext m_context;
+    EGLSurface m_surface;
+    GLFramebuffer* m_offscreen;
+    bool m_offscreenValid;
+    bool m_visible;
+};
+
+DesktopWindow* DesktopWindow::createHeadless(DesktopWindowClient* client, int width, int height)
+{
+    return new DesktopWindowEGL(client, width, height);
+}
+
+DesktopWindowEGL::DesktopWindowEGL(DesktopWindowClient* client, int width, int height)
+    : DesktopWindow(client, width, height)
+    , m_display(EGL_NO_DISPLAY)
+    , m_context(EGL_NO_CONTEXT)
+    , m_surface(EGL_NO_SURFACE)
+    , m_offscreen(0)
+    , m_offscreenValid(false)
+    , m_visible(false)
+{
+    try {
+        setup();
+    } catch(const FatalError&) {
+        freeResources();
+        throw;
+    }
+}
+
+DesktopWindowEGL::~DesktopWindowEGL()
+{
+    freeResources();
+}
+
+EGLDisplay DesktopWindowEGL::openDisplay()
+{
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+            if (display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+
+    // Drivers without the surfaceless platform may still work without a display server on their
+    // default one, e.g. Mesa with EGL_PLATFORM=drm.
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+void DesktopWindowEGL::setup()
+{
+    m_display = openDisplay();
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, 0, 0))
+        throw FatalError("Couldn't initialize an EGL display");
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+        throw FatalError("EGL display has no OpenGL support");
+
+    bool surfaceless = hasExtension(eglQueryString(m_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+    EGLint attributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 1,
+        EGL_GREEN_SIZE, 1,
+        EGL_BLUE_SIZE, 1,
+        EGL_ALPHA_SIZE, 1,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint numReturned = 0;
+    if (!eglChooseConfig(m_display, attributes, &config, 1, &numReturned) || !numReturned)
+        throw FatalError("No appropriate EGL config found.");
+
+    if (!surfaceless) {
+        EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        m_surface = eglCreatePbufferSurface(m_display, config, pbufferAttributes);
+        if (m_surface == EGL_NO_SURFACE)
+            throw FatalError("eglCreatePbufferSurface() failed.");
+    }
+
+    m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, 0);
+    if (m_context == EGL_NO_CONTEXT)
+        throw FatalError("eglCreateContext() failed.");
+
+    makeCurrent();
+    m_offscreen = new GLFramebuffer;
+    m_offscreen->resize(m_size);
+    if (!m_offscreen->isComplete())
+        throw FatalError("Could not create the offscreen framebuffer.");
+
+    const char* vendor = eglQueryString(m_display, EGL_VENDOR);
+    std::cerr << "Rendering headless on " << (surfaceless ? "a surfaceless context" : "a pbuffer")
+        << " (EGL vendor: " << (vendor ? vendor : "unknown") << ").\n";
+}
+
+void DesktopWindowEGL::freeResources()
+{
+    if (m_display == EGL_NO_DISPLAY)
+        return;
+
+    if (m_offscreen) {
+        makeCurrent();
+        delete m_offscreen;
+    }
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_context != EGL_NO_CONTEXT)
+        eglDestroyContext(m_display, m_context);
+    if (m_surface != EGL_NO_SURFACE)
+        eglDestroySurface(m_display, m_surface);
+    eglTerminate(m_display);
+}
+
+void DesktopWindowEGL::makeCurrent()
+{
+    eglMakeCurrent(m_display, m_surface, m_surface, m_context);
+}
+
+void DesktopWindowEGL::doneCurrent()
+{
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void DesktopWindowEGL::beginFrame(const WKSize& size)
+{
+    // Resized here since only the thread painting may touch the GL context.
+    if (m_offscreen->resize(size))
+        m_offscreenValid = false;
+}
+
+unsigned DesktopWindowEGL::framebuffer()
+{
+    return m_offscreen->id();
+}
+
+void DesktopWindowEGL::setSize(const WKSize& size)
+{
+    if (size.width == m_size.width && size.height == m_size.height)
+        return;
+
+    m_size = size;
+    if (m_client)
+        m_client->onWindowSizeChange(m_size);
+}
+
+const char* DesktopWindowEGL::presentationMethod() const
+{
+    return "headless EGL";
+}
+
+int DesktopWindowEGL::bufferAge()
+{
+    return m_offscreenValid ? 1 : 0;
+}
+
+void DesktopWindowEGL::swapBuffers(const WKRect&)
+{
+    // Nothing to present, the frame stays in the offscreen framebuffer for whoever reads it back.
+    glFlush();
+    m_offscreenValid = true;
+}
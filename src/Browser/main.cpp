@@ -25,20 +25,116 @@
 
 #include "Browser.h"
 #include "FatalError.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <vector>
-#include <algorithm>
-#include <iterator>
 
 using namespace std;
 
+static void printUsage(const char* program)
+{
+    cerr << "Usage: " << program << " [options] [url...]" << endl
+         << "Options:" << endl
+         << "  --threaded-compositor    Paint and swap buffers on a dedicated thread (experimental: views may be" << endl
+         << "                           painted while their scene changes)" << endl
+         << "  --headless               Render offscreen through EGL, without a display server" << endl
+         << "  --hud                    Show frame timings over the page from startup" << endl
+         << "  --presentation=MODE      Present frames with swap or shm, or auto to use shm on software renderers" << endl
+         << "  --swap-interval=N        Swap buffers every N vblanks, 0 not waiting for them" << endl
+         << "  --screenshot=FILE        Save the page to FILE (PNG, or PPM if named *.ppm) once loaded and quit" << endl
+         << "  --record-video=FILE      Record the window to FILE (WebM, or MP4 if named *.mp4)" << endl
+         << "  --record-input=FILE      Log input events and window size changes to FILE" << endl
+         << "  --replay-input=FILE      Replay the input logged in FILE once the page loads, then quit" << endl
+         << "  --replay-fast            Replay the input as fast as possible instead of at its pace" << endl
+         << "  --process-model=MODEL    Web processes per-tab (default), shared by all tabs, or per-site" << endl
+         << "  --max-processes=N        Web processes of the per-site model, then sites share them (default: 8)" << endl
+         << "  --tab-pool=N             Keep N web processes warm for new tabs (default: 1)" << endl
+         << "  --live-tabs=N            Discard hidden tabs while more than N are loaded, 0 never does (default: 8)" << endl
+         << "  --discard-after=SECONDS  Only discard tabs hidden for more than SECONDS (default: 60)" << endl
+         << "  --max-loads=N            Load N of the URLs given at once, once the visible one is loaded (default: 3)" << endl;
+}
+
+static bool parseArguments(int argc, const char** argv, BrowserOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--", 2)) {
+            options.urls.push_back(arg);
+            continue;
+        }
+
+        if (!strcmp(arg, "--threaded-compositor"))
+            options.threadedCompositor = true;
+        else if (!strcmp(arg, "--headless"))
+            options.headless = true;
+        else if (!strcmp(arg, "--hud"))
+            options.showHud = true;
+        else if (!strncmp(arg, "--presentation=", 15)) {
+            const char* mode = arg + 15;
+            if (!strcmp(mode, "auto"))
+                options.presentation = AutomaticPresentation;
+            else if (!strcmp(mode, "swap"))
+                options.presentation = SwapPresentation;
+            else if (!strcmp(mode, "shm"))
+                options.presentation = SharedMemoryPresentation;
+            else {
+                cerr << "Unknown presentation mode: " << mode << endl;
+                return false;
+            }
+        } else if (!strncmp(arg, "--swap-interval=", 16))
+            options.swapInterval = atoi(arg + 16);
+        else if (!strncmp(arg, "--screenshot=", 13))
+            options.screenshot = arg + 13;
+        else if (!strncmp(arg, "--record-video=", 15))
+            options.recordVideo = arg + 15;
+        else if (!strncmp(arg, "--record-input=", 15))
+            options.recordInput = arg + 15;
+        else if (!strncmp(arg, "--replay-input=", 15))
+            options.replayInput = arg + 15;
+        else if (!strcmp(arg, "--replay-fast"))
+            options.replayPaced = false;
+        else if (!strncmp(arg, "--process-model=", 16)) {
+            const char* model = arg + 16;
+            if (!strcmp(model, "per-tab"))
+                options.processModel = ProcessModel::ProcessPerTab;
+            else if (!strcmp(model, "shared"))
+                options.processModel = ProcessModel::SharedProcess;
+            else if (!strcmp(model, "per-site"))
+                options.processModel = ProcessModel::ProcessPerSite;
+            else {
+                cerr << "Unknown process model: " << model << endl;
+                return false;
+            }
+        } else if (!strncmp(arg, "--max-processes=", 16))
+            options.maxProcesses = std::max(1, atoi(arg + 16));
+        else if (!strncmp(arg, "--tab-pool=", 11))
+            options.tabPoolSize = std::max(0, atoi(arg + 11));
+        else if (!strncmp(arg, "--live-tabs=", 12))
+            options.liveTabs = std::max(0, atoi(arg + 12));
+        else if (!strncmp(arg, "--discard-after=", 16))
+            options.discardAfter = std::max(0, atoi(arg + 16));
+        else if (!strncmp(arg, "--max-loads=", 12))
+            options.maxConcurrentLoads = std::max(1, atoi(arg + 12));
+        else {
+            cerr << "Unknown option: " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, const char** argv)
 {
     try {
-        std::vector<std::string> args;
-        std::copy(&argv[1], &argv[argc], std::back_inserter(args));
+        BrowserOptions options;
+        if (!parseArguments(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
 
-        Browser browser(args);
+        Browser browser(options);
         return browser.run();
     } catch (const FatalError& e) {
         cerr << e.what() << endl;
@@ -1,20 +1,42 @@
 browser = Executable:new("drowser")
 browser:use(glib)
+browser:use(cairo)
 browser:use(openGL)
+browser:use(egl)
+browser:use(gstreamer)
+browser:use(gstreamerApp)
 browser:use(x11)
+browser:use(xext)
+browser:use(xi)
 browser:use(nix)
 
 browser:addFiles([[
   main.cpp
   Browser.cpp
+  Compositor.cpp
   DesktopWindow.cpp
+  FrameScheduler.cpp
+  GLFramebuffer.cpp
+  GLReadback.cpp
+  Hud.cpp
   InjectedBundleGlue.cpp
+  InputLatency.cpp
+  InputRecorder.cpp
+  InputReplayer.cpp
+  LoadScheduler.cpp
+  MainLoopScheduling.cpp
+  ProcessModel.cpp
+  ScreenshotCapturer.cpp
   Tab.cpp
+  TabPool.cpp
+  ThumbnailAtlas.cpp
+  VideoRecorder.cpp
 
   ../Shared/WKConversions.cpp
 ]])
 
 UNIX:browser:addFiles([[
+  egl/DesktopWindowEGL.cpp
   x11/DesktopWindowLinux.cpp
   x11/XlibEventSource.cpp
 ]])
@@ -25,20 +25,38 @@
 
 #include "DesktopWindow.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <GL/glx.h>
+#include <glib.h>
 #include <iostream>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <vector>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/cursorfont.h>
+#include <X11/extensions/XInput2.h>
+#include <X11/extensions/XShm.h>
 
 #include "FatalError.h"
+#include "GLFramebuffer.h"
 #include "XlibEventSource.h"
 #include "XlibEventUtils.h"
 
 static Atom wmDeleteMessageAtom;
 static const double DOUBLE_CLICK_INTERVAL = 300;
+// Same constant we use inside WebView to calculate the ticks. See also WebCore::Scrollbar::pixelsPerLineStep().
+static const float pixelsPerScrollStep = 40.0f;
+
+// Core protocol wheel notches: up, down, left and right, each a press immediately followed by a release.
+static inline bool isWheelButton(unsigned button)
+{
+    return button >= 4 && button <= 7;
+}
 
 class ScopedXFree
 {
@@ -50,29 +68,151 @@ private:
     void* m_ptr;
 };
 
+static void (*getProcAddress(const char* name))()
+{
+    return glXGetProcAddress(reinterpret_cast<const GLubyte*>(name));
+}
+
+static int fbConfigAttribute(Display* display, GLXFBConfig config, int attribute)
+{
+    int value = 0;
+    glXGetFBConfigAttrib(display, config, attribute, &value);
+    return value;
+}
+
+// Lower is better, compared in order: every buffer nothing paints into still costs memory and
+// bandwidth on each frame, which software rasterizers feel the most.
+static void scoreFBConfig(Display* display, GLXFBConfig config, int screenDepth, int score[7])
+{
+    XVisualInfo* visual = glXGetVisualFromFBConfig(display, config);
+    score[0] = fbConfigAttribute(display, config, GLX_CONFIG_CAVEAT) != GLX_NONE;
+    score[1] = !visual || visual->depth != screenDepth;
+    score[2] = fbConfigAttribute(display, config, GLX_DEPTH_SIZE);
+    score[3] = fbConfigAttribute(display, config, GLX_STENCIL_SIZE);
+    score[4] = fbConfigAttribute(display, config, GLX_SAMPLES);
+    score[5] = fbConfigAttribute(display, config, GLX_RED_SIZE) + fbConfigAttribute(display, config, GLX_GREEN_SIZE)
+        + fbConfigAttribute(display, config, GLX_BLUE_SIZE);
+    score[6] = fbConfigAttribute(display, config, GLX_ALPHA_SIZE);
+    if (visual)
+        XFree(visual);
+}
+
+static GLXFBConfig chooseFBConfig(Display* display, GLXFBConfig* configs, int count)
+{
+    int screenDepth = DefaultDepth(display, DefaultScreen(display));
+    GLXFBConfig best = configs[0];
+    int bestScore[7];
+    scoreFBConfig(display, best, screenDepth, bestScore);
+    for (int i = 1; i < count; ++i) {
+        int score[7];
+        scoreFBConfig(display, configs[i], screenDepth, score);
+        if (std::lexicographical_compare(score, score + 7, bestScore, bestScore + 7)) {
+            best = configs[i];
+            std::copy(score, score + 7, bestScore);
+        }
+    }
+    return best;
+}
+
+static bool isSoftwareRenderer(const char* renderer)
+{
+    return renderer && (strstr(renderer, "llvmpipe") || strstr(renderer, "softpipe")
+        || strstr(renderer, "Software Rasterizer") || strstr(renderer, "swrast"));
+}
+
 class DesktopWindowLinux : public DesktopWindow, public XlibEventSource::Client {
 public:
-    DesktopWindowLinux(DesktopWindowClient* client, int width, int height, bool visible);
+    DesktopWindowLinux(DesktopWindowClient* client, int width, int height, bool visible, PresentationMode);
     ~DesktopWindowLinux();
     void makeCurrent();
-    void swapBuffers();
+    void doneCurrent();
+    bool setSwapInterval(int);
+    void beginFrame(const WKSize&);
+    unsigned framebuffer();
+    const char* presentationMethod() const;
+    int bufferAge();
+    void swapBuffers(const WKRect& damagedRect);
+    bool vsyncTiming(int64_t& lastVBlank, int64_t& interval);
+    void dumpStatistics(std::ostream&) const;
     void setMouseCursor(unsigned shape);
     void setVisible(bool);
     bool visible() const;
     void setPosition(const WKPoint& position);
+    void setSize(const WKSize&);
 
 private:
     void freeResources();
     void setup();
     void destroyGLContext();
     void updateSizeIfNeeded(int width, int height);
+    void updateOcclusion();
+    void sampleVideoSync();
+
+    struct SharedImage;
+    void setupPresentation(PresentationMode);
+    bool createSharedImages();
+    bool createSharedImage(SharedImage&);
+    void destroySharedImages();
+    void putSharedImage(const WKRect& damagedRect);
+
+    void setupSmoothScrolling();
+    void updateScrollValuators(int deviceId);
+    void handleXIEvent(XGenericEventCookie&);
+    void handleXIMotion(const XIDeviceEvent&);
+    void handleXIButton(const XIDeviceEvent&);
 
     void sendKeyboardEventToNix(const XEvent& event);
     void handleXEvent(const XEvent&);
+    void didHandleXEvents();
+    void queueMouseMove(const NIXMouseEvent&);
+    void queueMouseWheel(NIXWheelEvent);
+    void sendQueuedMouseMove();
+    void sendQueuedMouseWheel();
     void updateClickCount(const XButtonPressedEvent* event);
 
     XVisualInfo* m_visualInfo;
     GLXContext m_context;
+    bool m_hasBufferAge;
+    PFNGLXCOPYSUBBUFFERMESAPROC m_copySubBuffer;
+    // Reset on the main thread when the window is resized, used by the compositor thread when threaded.
+    std::atomic<bool> m_backBufferPreserved;
+    PFNGLXGETSYNCVALUESOMLPROC m_getSyncValues;
+    PFNGLXGETMSCRATEOMLPROC m_getMscRate;
+    PFNGLXGETVIDEOSYNCSGIPROC m_getVideoSync;
+    PFNGLXSWAPINTERVALEXTPROC m_swapIntervalEXT;
+    PFNGLXSWAPINTERVALMESAPROC m_swapIntervalMESA;
+    PFNGLXSWAPINTERVALSGIPROC m_swapIntervalSGI;
+    // Sampled by whichever thread has the context current, read by the frame scheduler.
+    GMutex m_videoSyncMutex;
+    unsigned m_videoSyncCount;
+    int64_t m_videoSyncTime;
+    int64_t m_videoSyncInterval;
+
+    // Size of the frame being painted, only touched by the painting thread.
+    WKSize m_frameSize;
+
+    // Software presentation: frames are painted into m_offscreen and read back into a MIT-SHM
+    // image, sparing the extra full frame copy glXSwapBuffers does on software rasterizers. Frames
+    // alternate between two images, one is written while the server may still be reading the other.
+    struct SharedImage {
+        XImage* image;
+        XShmSegmentInfo info;
+        // Request serial of the latest put, the image can be written again once it's completed.
+        unsigned long putSerial;
+    };
+    GLFramebuffer* m_offscreen;
+    // m_offscreen holds the previous frame.
+    bool m_offscreenValid;
+    SharedImage m_sharedImages[2];
+    unsigned m_nextSharedImage;
+    // The window has to be presented whole, the shared images were just created.
+    bool m_sharedImagesFresh;
+    int m_shmCompletionEvent;
+    // Serial of the latest put the server reported completed, written by the thread handling events.
+    std::atomic<unsigned long> m_shmCompletedSerial;
+    unsigned m_sharedImageWaits;
+    GC m_gc;
+    std::vector<unsigned char> m_readback;
     XlibEventSource* m_eventSource;
     Display* m_display;
     Window m_window;
@@ -87,15 +227,69 @@ private:
     WKEventMouseButton m_lastClickButton;
     int m_clickCount;
     bool m_visible;
+    bool m_mapped;
+    bool m_fullyObscured;
+    bool m_occluded;
+
+    // With XInput 2.1, scrolling comes from the scroll valuators of the pointer devices, whose
+    // positions only make sense relative to the previous one.
+    struct ScrollValuator {
+        int deviceId;
+        int number;
+        bool horizontal;
+        double increment;
+        double lastValue;
+        bool hasLastValue;
+    };
+    int m_xiOpcode;
+    std::vector<ScrollValuator> m_scrollValuators;
+
+    // Motion and wheel events are held back until the end of the dispatch batch, so that a run of
+    // them reaches the page as a single event instead of flooding the web process. Wheel events
+    // are held per orientation, diagonal scrolling alternates them.
+    NIXMouseEvent m_queuedMouseMove;
+    bool m_hasQueuedMouseMove;
+    NIXWheelEvent m_queuedMouseWheel[2];
+    bool m_hasQueuedMouseWheel[2];
+    // When the first event of each merged run was received, for the latency statistics.
+    int64_t m_queuedMouseMoveTime;
+    int64_t m_queuedMouseWheelTime[2];
+    unsigned m_mouseMovesReceived;
+    unsigned m_mouseMovesMerged;
+    unsigned m_mouseWheelsReceived;
+    unsigned m_mouseWheelsMerged;
 };
 
-DesktopWindow* DesktopWindow::create(DesktopWindowClient* client, int width, int height, bool visible)
+DesktopWindow* DesktopWindow::create(DesktopWindowClient* client, int width, int height, bool visible, PresentationMode presentation)
 {
-    return new DesktopWindowLinux(client, width, height, visible);
+    return new DesktopWindowLinux(client, width, height, visible, presentation);
 }
 
-DesktopWindowLinux::DesktopWindowLinux(DesktopWindowClient* client, int width, int height, bool visible)
+DesktopWindowLinux::DesktopWindowLinux(DesktopWindowClient* client, int width, int height, bool visible, PresentationMode presentation)
     : DesktopWindow(client, width, height)
+    , m_visualInfo(0)
+    , m_context(0)
+    , m_hasBufferAge(false)
+    , m_copySubBuffer(0)
+    , m_backBufferPreserved(false)
+    , m_getSyncValues(0)
+    , m_getMscRate(0)
+    , m_getVideoSync(0)
+    , m_swapIntervalEXT(0)
+    , m_swapIntervalMESA(0)
+    , m_swapIntervalSGI(0)
+    , m_videoSyncCount(0)
+    , m_videoSyncTime(0)
+    , m_videoSyncInterval(0)
+    , m_frameSize(WKSizeMake(width, height))
+    , m_offscreen(0)
+    , m_offscreenValid(false)
+    , m_nextSharedImage(0)
+    , m_sharedImagesFresh(false)
+    , m_shmCompletionEvent(0)
+    , m_shmCompletedSerial(0)
+    , m_sharedImageWaits(0)
+    , m_gc(0)
     , m_eventSource(0)
     , m_display(0)
     , m_window(0)
@@ -109,7 +303,22 @@ DesktopWindowLinux::DesktopWindowLinux(DesktopWindowClient* client, int width, i
     , m_lastClickButton(kWKEventMouseButtonNoButton)
     , m_clickCount(0)
     , m_visible(visible)
+    , m_mapped(false)
+    , m_fullyObscured(false)
+    , m_occluded(false)
+    , m_xiOpcode(0)
+    , m_hasQueuedMouseMove(false)
+    , m_queuedMouseMoveTime(0)
+    , m_mouseMovesReceived(0)
+    , m_mouseMovesMerged(0)
+    , m_mouseWheelsReceived(0)
+    , m_mouseWheelsMerged(0)
 {
+    m_hasQueuedMouseWheel[0] = m_hasQueuedMouseWheel[1] = false;
+    m_queuedMouseWheelTime[0] = m_queuedMouseWheelTime[1] = 0;
+    memset(m_sharedImages, 0, sizeof(m_sharedImages));
+    g_mutex_init(&m_videoSyncMutex);
+
     try {
         setup();
     } catch(const FatalError&) {
@@ -120,17 +329,21 @@ DesktopWindowLinux::DesktopWindowLinux(DesktopWindowClient* client, int width, i
     m_eventSource = new XlibEventSource(m_display, this);
 
     makeCurrent();
-    glEnable(GL_DEPTH_TEST);
+    setupPresentation(presentation);
 }
 
 DesktopWindowLinux::~DesktopWindowLinux()
 {
     freeResources();
+    g_mutex_clear(&m_videoSyncMutex);
 }
 
 void DesktopWindowLinux::freeResources()
 {
     delete m_eventSource;
+    destroySharedImages();
+    if (m_gc)
+        XFreeGC(m_display, m_gc);
     if (m_context)
         destroyGLContext();
     if (m_window)
@@ -150,13 +363,287 @@ void DesktopWindowLinux::makeCurrent()
     glXMakeCurrent(m_display, m_window, m_context);
 }
 
-void DesktopWindowLinux::swapBuffers()
+void DesktopWindowLinux::doneCurrent()
 {
+    glXMakeCurrent(m_display, None, 0);
+}
+
+bool DesktopWindowLinux::setSwapInterval(int interval)
+{
+    if (m_swapIntervalEXT) {
+        m_swapIntervalEXT(m_display, m_window, interval);
+        return true;
+    }
+    // These two apply to the current context.
+    if (m_swapIntervalMESA)
+        return !m_swapIntervalMESA(interval);
+    // SGI_swap_control can't turn synchronization off.
+    if (m_swapIntervalSGI && interval > 0)
+        return !m_swapIntervalSGI(interval);
+    return false;
+}
+
+void DesktopWindowLinux::beginFrame(const WKSize& size)
+{
+    m_frameSize = size;
+    if (m_offscreen && m_offscreen->resize(size))
+        m_offscreenValid = false;
+}
+
+unsigned DesktopWindowLinux::framebuffer()
+{
+    return m_offscreen ? m_offscreen->id() : 0;
+}
+
+const char* DesktopWindowLinux::presentationMethod() const
+{
+    return m_offscreen ? "MIT-SHM" : "GLX swap";
+}
+
+int DesktopWindowLinux::bufferAge()
+{
+    // The offscreen framebuffer is never swapped, it always holds the previous frame.
+    if (m_offscreen)
+        return m_offscreenValid ? 1 : 0;
+
+    if (m_backBufferPreserved)
+        return 1;
+
+    if (!m_hasBufferAge)
+        return 0;
+
+    unsigned int age = 0;
+    glXQueryDrawable(m_display, m_window, GLX_BACK_BUFFER_AGE_EXT, &age);
+    return age;
+}
+
+void DesktopWindowLinux::swapBuffers(const WKRect& damagedRect)
+{
+    // With a threaded compositor the frame scheduler runs where the context isn't current.
+    if (m_getVideoSync && !m_getSyncValues)
+        sampleVideoSync();
+
+    if (m_offscreen) {
+        putSharedImage(damagedRect);
+        return;
+    }
+
+    bool fullWindow = damagedRect.origin.x <= 0 && damagedRect.origin.y <= 0
+        && damagedRect.origin.x + damagedRect.size.width >= m_frameSize.width
+        && damagedRect.origin.y + damagedRect.size.height >= m_frameSize.height;
+
+    // MESA_copy_sub_buffer copies just the damaged rect to the front buffer and leaves the back
+    // buffer untouched, so the next frame only has to repaint its own damage.
+    if (m_copySubBuffer && !fullWindow) {
+        int x = damagedRect.origin.x;
+        int y = m_frameSize.height - (damagedRect.origin.y + damagedRect.size.height);
+        m_copySubBuffer(m_display, m_window, x, y, damagedRect.size.width, damagedRect.size.height);
+        m_backBufferPreserved = true;
+        return;
+    }
+
     glXSwapBuffers(m_display, m_window);
+    m_backBufferPreserved = false;
+}
+
+void DesktopWindowLinux::putSharedImage(const WKRect& damagedRect)
+{
+    XImage* current = m_sharedImages[0].image;
+    if (current && (current->width != m_frameSize.width || current->height != m_frameSize.height))
+        destroySharedImages();
+    if (!m_sharedImages[0].image && !createSharedImages())
+        return;
+
+    WKRect rect = m_sharedImagesFresh ? WKRectMake(0, 0, m_frameSize.width, m_frameSize.height) : damagedRect;
+    int x = std::max<int>(0, rect.origin.x);
+    int y = std::max<int>(0, rect.origin.y);
+    int width = std::min<int>(m_frameSize.width, rect.origin.x + rect.size.width) - x;
+    int height = std::min<int>(m_frameSize.height, rect.origin.y + rect.size.height) - y;
+    if (width <= 0 || height <= 0)
+        return;
+
+    SharedImage& shared = m_sharedImages[m_nextSharedImage];
+    m_nextSharedImage ^= 1;
+    // The put from two frames ago has normally completed long ago. If not, the server is that far
+    // behind and waiting for it is all there is left to do.
+    if (shared.putSerial && m_shmCompletedSerial < shared.putSerial) {
+        XSync(m_display, False);
+        ++m_sharedImageWaits;
+    }
+
+    // A single read back of the damaged rect. GL rows go bottom up while XImage ones go top down,
+    // hence the flip when copying into the shared segment.
+    size_t rowLength = width * 4;
+    m_readback.resize(rowLength * height);
+    m_offscreen->bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(x, m_frameSize.height - (y + height), width, height, GL_BGRA, GL_UNSIGNED_BYTE, &m_readback[0]);
+
+    for (int row = 0; row < height; ++row) {
+        memcpy(shared.image->data + (y + row) * shared.image->bytes_per_line + x * 4,
+            &m_readback[(height - 1 - row) * rowLength], rowLength);
+    }
+
+    // The ShmCompletion event tells when the server is done reading the segment. Locked so that
+    // no request from another thread comes between the serial and the put.
+    XLockDisplay(m_display);
+    shared.putSerial = XNextRequest(m_display);
+    XShmPutImage(m_display, m_window, m_gc, shared.image, x, y, x, y, width, height, True);
+    XUnlockDisplay(m_display);
+    XFlush(m_display);
+    m_offscreenValid = true;
+    m_sharedImagesFresh = false;
+}
+
+void DesktopWindowLinux::setupPresentation(PresentationMode presentation)
+{
+    const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    bool useSharedMemory = presentation == AutomaticPresentation ? isSoftwareRenderer(renderer) : presentation == SharedMemoryPresentation;
+    if (!useSharedMemory)
+        return;
+
+    // Pixels are read back as BGRA, which must match the visual layout as is.
+    bool compatibleVisual = m_visualInfo->red_mask == 0xff0000 && m_visualInfo->green_mask == 0xff00
+        && m_visualInfo->blue_mask == 0xff && ImageByteOrder(m_display) == LSBFirst;
+    if (!XShmQueryExtension(m_display) || !compatibleVisual) {
+        std::cerr << "MIT-SHM presentation not available, using GLX swap.\n";
+        return;
+    }
+
+    m_offscreen = new GLFramebuffer;
+    m_offscreen->resize(m_size);
+    if (!m_offscreen->isComplete() || !createSharedImages()) {
+        std::cerr << "Could not set up MIT-SHM presentation, using GLX swap.\n";
+        delete m_offscreen;
+        m_offscreen = 0;
+        return;
+    }
+
+    m_gc = XCreateGC(m_display, m_window, 0, 0);
+    m_shmCompletionEvent = XShmGetEventBase(m_display) + ShmCompletion;
+    std::cerr << "Presenting with MIT-SHM (GL renderer: " << (renderer ? renderer : "unknown") << ").\n";
+}
+
+bool DesktopWindowLinux::createSharedImages()
+{
+    if (!createSharedImage(m_sharedImages[0]) || !createSharedImage(m_sharedImages[1])) {
+        destroySharedImages();
+        return false;
+    }
+
+    m_nextSharedImage = 0;
+    // The whole window has to be presented again from the new segments.
+    m_sharedImagesFresh = true;
+    return true;
+}
+
+bool DesktopWindowLinux::createSharedImage(SharedImage& shared)
+{
+    XShmSegmentInfo& info = shared.info;
+    shared.putSerial = 0;
+    shared.image = XShmCreateImage(m_display, m_visualInfo->visual, m_visualInfo->depth, ZPixmap, 0,
+        &info, m_frameSize.width, m_frameSize.height);
+    if (!shared.image)
+        return false;
+
+    if (shared.image->bits_per_pixel != 32) {
+        XDestroyImage(shared.image);
+        shared.image = 0;
+        return false;
+    }
+
+    info.shmid = shmget(IPC_PRIVATE, shared.image->bytes_per_line * shared.image->height, IPC_CREAT | 0600);
+    if (info.shmid == -1) {
+        XDestroyImage(shared.image);
+        shared.image = 0;
+        return false;
+    }
+
+    info.shmaddr = shared.image->data = static_cast<char*>(shmat(info.shmid, 0, 0));
+    info.readOnly = True;
+    bool attached = info.shmaddr != reinterpret_cast<char*>(-1) && XShmAttach(m_display, &info);
+    XSync(m_display, False);
+    // Only the attachments keep the segment alive from now on.
+    shmctl(info.shmid, IPC_RMID, 0);
+
+    if (!attached) {
+        if (info.shmaddr != reinterpret_cast<char*>(-1))
+            shmdt(info.shmaddr);
+        shared.image->data = 0;
+        XDestroyImage(shared.image);
+        shared.image = 0;
+        return false;
+    }
+    return true;
+}
+
+void DesktopWindowLinux::destroySharedImages()
+{
+    // The server handles the detach after any pending put, the client mapping can go right away.
+    for (SharedImage& shared : m_sharedImages) {
+        if (!shared.image)
+            continue;
+        XShmDetach(m_display, &shared.info);
+        shared.image->data = 0;
+        XDestroyImage(shared.image);
+        shmdt(shared.info.shmaddr);
+        shared.image = 0;
+    }
+}
+
+bool DesktopWindowLinux::vsyncTiming(int64_t& lastVBlank, int64_t& interval)
+{
+    // UST is the CLOCK_MONOTONIC time of the last MSC increment, as is g_get_monotonic_time().
+    if (m_getSyncValues && m_getMscRate) {
+        int64_t ust, msc, sbc;
+        int32_t numerator, denominator;
+        if (m_getSyncValues(m_display, m_window, &ust, &msc, &sbc) && ust
+            && m_getMscRate(m_display, m_window, &numerator, &denominator) && numerator > 0) {
+            lastVBlank = ust;
+            interval = G_USEC_PER_SEC * int64_t(denominator) / numerator;
+            return true;
+        }
+    }
+
+    if (!m_getVideoSync)
+        return false;
+    if (glXGetCurrentContext() == m_context)
+        sampleVideoSync();
+
+    g_mutex_lock(&m_videoSyncMutex);
+    bool known = m_videoSyncInterval;
+    lastVBlank = m_videoSyncTime;
+    interval = m_videoSyncInterval;
+    g_mutex_unlock(&m_videoSyncMutex);
+    return known;
+}
+
+void DesktopWindowLinux::sampleVideoSync()
+{
+    // SGI_video_sync only exposes a counter, so the vblank times are estimated from when it was
+    // seen to change. Needs the context to be current.
+    unsigned count;
+    if (m_getVideoSync(&count))
+        return;
+
+    int64_t now = g_get_monotonic_time();
+    g_mutex_lock(&m_videoSyncMutex);
+    if (count != m_videoSyncCount) {
+        if (m_videoSyncTime && count > m_videoSyncCount) {
+            int64_t sample = (now - m_videoSyncTime) / (count - m_videoSyncCount);
+            m_videoSyncInterval = m_videoSyncInterval ? (7 * m_videoSyncInterval + sample) / 8 : sample;
+        }
+        m_videoSyncCount = count;
+        m_videoSyncTime = now;
+    }
+    g_mutex_unlock(&m_videoSyncMutex);
 }
 
 void DesktopWindowLinux::setup()
 {
+    // The compositor may present from its own thread. This must precede any other Xlib call.
+    XInitThreads();
+
     char* loc = setlocale(LC_ALL, "");
     if (!loc)
         std::cerr << "Could not use the the default environment locale.\n";
@@ -172,15 +659,17 @@ void DesktopWindowLinux::setup()
     if (!m_display)
         throw FatalError("Couldn't connect to X server");
 
+    // Neither depth nor stencil is asked for, but glXChooseFBConfig sorts configs with the most
+    // bits first, so candidates are scored by chooseFBConfig().
     int attributes[] = {
                 GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
                 GLX_DOUBLEBUFFER,  True,
                 GLX_RENDER_TYPE,
                 GLX_RGBA_BIT,
+                GLX_X_RENDERABLE,  True,
                 GLX_RED_SIZE,      1,
                 GLX_GREEN_SIZE,    1,
                 GLX_BLUE_SIZE,     1,
-                GLX_ALPHA_SIZE,    1,
                 GLX_TRANSPARENT_TYPE,
                 GLX_NONE,
                 None
@@ -188,10 +677,10 @@ void DesktopWindowLinux::setup()
 
     int numReturned = 0;
     GLXFBConfig* fbConfigs(glXChooseFBConfig(m_display, DefaultScreen(m_display), attributes, &numReturned));
-    if (!fbConfigs)
+    if (!fbConfigs || !numReturned)
         throw FatalError("No double buffered config available");
 
-    GLXFBConfig fbConfig = fbConfigs[0];
+    GLXFBConfig fbConfig = chooseFBConfig(m_display, fbConfigs, numReturned);
     ScopedXFree x(fbConfigs);
 
     m_visualInfo = glXGetVisualFromFBConfig(m_display, fbConfig);
@@ -200,7 +689,7 @@ void DesktopWindowLinux::setup()
 
     XSetWindowAttributes setAttributes;
     setAttributes.colormap = XCreateColormap(m_display, DefaultRootWindow(m_display), m_visualInfo->visual, AllocNone);
-    setAttributes.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | StructureNotifyMask | PointerMotionMask;
+    setAttributes.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | StructureNotifyMask | PointerMotionMask | VisibilityChangeMask;
     m_window = XCreateWindow(m_display, DefaultRootWindow(m_display),
                                 0, 0, m_size.width, m_size.height, 0,
                                 m_visualInfo->depth, InputOutput, m_visualInfo->visual,
@@ -221,14 +710,215 @@ void DesktopWindowLinux::setup()
         XMapWindow(m_display, m_window);
 
     XStoreName(m_display, m_window, "Drowser");
+    setupSmoothScrolling();
 
     m_context = glXCreateNewContext(m_display, fbConfig, GLX_RGBA_TYPE, NULL, GL_TRUE);
     if (!m_context)
         throw FatalError("glXCreateContext() failed.");
+
+    const char* extensions = glXQueryExtensionsString(m_display, DefaultScreen(m_display));
+
+    m_hasBufferAge = hasExtension(extensions, "GLX_EXT_buffer_age");
+    if (hasExtension(extensions, "GLX_MESA_copy_sub_buffer"))
+        m_copySubBuffer = reinterpret_cast<PFNGLXCOPYSUBBUFFERMESAPROC>(getProcAddress("glXCopySubBufferMESA"));
+    if (hasExtension(extensions, "GLX_OML_sync_control")) {
+        m_getSyncValues = reinterpret_cast<PFNGLXGETSYNCVALUESOMLPROC>(getProcAddress("glXGetSyncValuesOML"));
+        m_getMscRate = reinterpret_cast<PFNGLXGETMSCRATEOMLPROC>(getProcAddress("glXGetMscRateOML"));
+    }
+    if (hasExtension(extensions, "GLX_SGI_video_sync"))
+        m_getVideoSync = reinterpret_cast<PFNGLXGETVIDEOSYNCSGIPROC>(getProcAddress("glXGetVideoSyncSGI"));
+    if (hasExtension(extensions, "GLX_EXT_swap_control"))
+        m_swapIntervalEXT = reinterpret_cast<PFNGLXSWAPINTERVALEXTPROC>(getProcAddress("glXSwapIntervalEXT"));
+    else if (hasExtension(extensions, "GLX_MESA_swap_control"))
+        m_swapIntervalMESA = reinterpret_cast<PFNGLXSWAPINTERVALMESAPROC>(getProcAddress("glXSwapIntervalMESA"));
+    else if (hasExtension(extensions, "GLX_SGI_swap_control"))
+        m_swapIntervalSGI = reinterpret_cast<PFNGLXSWAPINTERVALSGIPROC>(getProcAddress("glXSwapIntervalSGI"));
+}
+
+void DesktopWindowLinux::setupSmoothScrolling()
+{
+    int event, error;
+    if (!XQueryExtension(m_display, "XInputExtension", &m_xiOpcode, &event, &error)) {
+        m_xiOpcode = 0;
+        return;
+    }
+
+    int major = 2;
+    int minor = 1;
+    if (XIQueryVersion(m_display, &major, &minor) != Success || (major == 2 && minor < 1)) {
+        m_xiOpcode = 0;
+        return;
+    }
+
+    // XI2 events replace the core ones for this client, so pointer motion comes through XI_Motion
+    // from now on, along with the scroll valuators, and buttons through XI_ButtonPress and release.
+    unsigned char mask[XIMaskLen(XI_LASTEVENT)] = { 0 };
+    XISetMask(mask, XI_Motion);
+    XISetMask(mask, XI_ButtonPress);
+    XISetMask(mask, XI_ButtonRelease);
+    XISetMask(mask, XI_Enter);
+    XISetMask(mask, XI_DeviceChanged);
+    XIEventMask eventMask;
+    eventMask.deviceid = XIAllMasterDevices;
+    eventMask.mask_len = sizeof(mask);
+    eventMask.mask = mask;
+    XISelectEvents(m_display, m_window, &eventMask, 1);
+    updateScrollValuators(XIAllMasterDevices);
+}
+
+void DesktopWindowLinux::updateScrollValuators(int deviceId)
+{
+    int count = 0;
+    XIDeviceInfo* devices = XIQueryDevice(m_display, deviceId, &count);
+    if (!devices)
+        return;
+
+    for (int i = 0; i < count; ++i) {
+        const XIDeviceInfo& device = devices[i];
+        m_scrollValuators.erase(std::remove_if(m_scrollValuators.begin(), m_scrollValuators.end(), [&device](const ScrollValuator& valuator) {
+            return valuator.deviceId == device.deviceid;
+        }), m_scrollValuators.end());
+
+        for (int j = 0; j < device.num_classes; ++j) {
+            if (device.classes[j]->type != XIScrollClass)
+                continue;
+            const XIScrollClassInfo* scroll = reinterpret_cast<const XIScrollClassInfo*>(device.classes[j]);
+            if (!scroll->increment)
+                continue;
+            ScrollValuator valuator = { device.deviceid, scroll->number, scroll->scroll_type != XIScrollTypeVertical, scroll->increment, 0, false };
+            for (int k = 0; k < device.num_classes; ++k) {
+                const XIValuatorClassInfo* axis = reinterpret_cast<const XIValuatorClassInfo*>(device.classes[k]);
+                if (axis->type == XIValuatorClass && axis->number == valuator.number) {
+                    valuator.lastValue = axis->value;
+                    valuator.hasLastValue = true;
+                }
+            }
+            m_scrollValuators.push_back(valuator);
+        }
+    }
+    XIFreeDeviceInfo(devices);
+}
+
+void DesktopWindowLinux::handleXIEvent(XGenericEventCookie& cookie)
+{
+    if (!XGetEventData(m_display, &cookie))
+        return;
+
+    switch (cookie.evtype) {
+    case XI_DeviceChanged:
+        // Also sent when another slave device starts driving the master, taking its valuators.
+        updateScrollValuators(reinterpret_cast<XIDeviceChangedEvent*>(cookie.data)->deviceid);
+        break;
+    case XI_Enter: {
+        // The valuators may have moved while the pointer was in other windows.
+        int deviceId = reinterpret_cast<XIEnterEvent*>(cookie.data)->deviceid;
+        for (ScrollValuator& valuator : m_scrollValuators) {
+            if (valuator.deviceId == deviceId)
+                valuator.hasLastValue = false;
+        }
+        break;
+    }
+    case XI_Motion:
+        handleXIMotion(*reinterpret_cast<XIDeviceEvent*>(cookie.data));
+        break;
+    case XI_ButtonPress:
+    case XI_ButtonRelease:
+        handleXIButton(*reinterpret_cast<XIDeviceEvent*>(cookie.data));
+        break;
+    }
+    XFreeEventData(m_display, &cookie);
+}
+
+void DesktopWindowLinux::handleXIButton(const XIDeviceEvent& event)
+{
+    // The server emulates wheel buttons from the scroll valuators, whose motion already scrolled.
+    // Devices without any, like XTest ones or wheels lacking smooth scrolling, send real ones.
+    if (event.flags & XIPointerEmulated)
+        return;
+
+    // Handled as the core event it replaces.
+    XEvent coreEvent;
+    memset(&coreEvent, 0, sizeof(coreEvent));
+    XButtonEvent& button = coreEvent.xbutton;
+    button.type = event.evtype == XI_ButtonPress ? ButtonPress : ButtonRelease;
+    button.display = m_display;
+    button.window = event.event;
+    button.root = event.root;
+    button.subwindow = event.child;
+    button.time = event.time;
+    button.x = event.event_x;
+    button.y = event.event_y;
+    button.x_root = event.root_x;
+    button.y_root = event.root_y;
+    button.state = event.mods.effective;
+    button.button = event.detail;
+    button.same_screen = True;
+    handleXEvent(coreEvent);
+}
+
+void DesktopWindowLinux::handleXIMotion(const XIDeviceEvent& event)
+{
+    double delta[2] = { 0, 0 };
+    const double* value = event.valuators.values;
+    for (int number = 0; number < event.valuators.mask_len * 8; ++number) {
+        if (!XIMaskIsSet(event.valuators.mask, number))
+            continue;
+        for (ScrollValuator& valuator : m_scrollValuators) {
+            if (valuator.deviceId != event.deviceid || valuator.number != number)
+                continue;
+            // Valuators grow when scrolling down or right, wheel deltas are positive upwards or leftwards.
+            if (valuator.hasLastValue)
+                delta[valuator.horizontal] -= (*value - valuator.lastValue) / valuator.increment * pixelsPerScrollStep;
+            valuator.lastValue = *value;
+            valuator.hasLastValue = true;
+        }
+        ++value;
+    }
+
+    unsigned modifiers = convertXEventModifiersToNativeModifiers(event.mods.effective);
+    double timestamp = convertXEventTimeToNixTimestamp(event.time);
+    if (!delta[0] && !delta[1]) {
+        sendQueuedMouseWheel();
+        NIXMouseEvent ev;
+        ev.type = kNIXInputEventTypeMouseMove;
+        ev.button = m_lastClickButton;
+        ev.x = event.event_x;
+        ev.y = event.event_y;
+        ev.globalX = event.root_x;
+        ev.globalY = event.root_y;
+        ev.clickCount = 0;
+        ev.modifiers = modifiers;
+        ev.timestamp = timestamp;
+        queueMouseMove(ev);
+        return;
+    }
+
+    // Smooth scrolling moves no pointer, the scroll has to come after the moves before it.
+    sendQueuedMouseMove();
+    for (int horizontal = 0; horizontal < 2; ++horizontal) {
+        if (!delta[horizontal])
+            continue;
+        NIXWheelEvent ev;
+        ev.type = kNIXInputEventTypeWheel;
+        ev.modifiers = modifiers;
+        ev.timestamp = timestamp;
+        ev.x = event.event_x;
+        ev.y = event.event_y;
+        ev.globalX = event.root_x;
+        ev.globalY = event.root_y;
+        ev.delta = delta[horizontal];
+        ev.orientation = horizontal ? kNIXWheelEventOrientationHorizontal : kNIXWheelEventOrientationVertical;
+        queueMouseWheel(ev);
+    }
 }
 
 void DesktopWindowLinux::destroyGLContext()
 {
+    if (m_offscreen) {
+        glXMakeCurrent(m_display, m_window, m_context);
+        delete m_offscreen;
+        m_offscreen = 0;
+    }
     glXMakeCurrent(m_display, None, 0);
     glXDestroyContext(m_display, m_context);
     XFree(m_visualInfo);
@@ -304,6 +994,26 @@ void DesktopWindowLinux::sendKeyboardEventToNix(const XEvent& event)
 
 void DesktopWindowLinux::handleXEvent(const XEvent& event)
 {
+    m_inputEventTime = g_get_monotonic_time();
+
+    if (m_xiOpcode && event.type == GenericEvent && event.xcookie.extension == m_xiOpcode) {
+        XGenericEventCookie cookie = event.xcookie;
+        handleXIEvent(cookie);
+        return;
+    }
+
+    if (m_shmCompletionEvent && event.type == m_shmCompletionEvent) {
+        m_shmCompletedSerial = event.xany.serial;
+        return;
+    }
+
+    // Anything else breaks a run of mergeable events, which must reach the client in order.
+    if (event.type != MotionNotify)
+        sendQueuedMouseMove();
+    bool wheelNotch = (event.type == ButtonPress || event.type == ButtonRelease) && isWheelButton(event.xbutton.button);
+    if (!wheelNotch)
+        sendQueuedMouseWheel();
+
     if (event.type == ConfigureNotify) {
         updateSizeIfNeeded(event.xconfigure.width, event.xconfigure.height);
         return;
@@ -316,6 +1026,16 @@ void DesktopWindowLinux::handleXEvent(const XEvent& event)
     case Expose:
         m_client->onWindowExpose();
         break;
+    case MapNotify:
+    case UnmapNotify:
+        // Window managers unmap minimized windows.
+        m_mapped = event.type == MapNotify;
+        updateOcclusion();
+        break;
+    case VisibilityNotify:
+        m_fullyObscured = event.xvisibility.state == VisibilityFullyObscured;
+        updateOcclusion();
+        break;
     case KeyPress:
     case KeyRelease:
         sendKeyboardEventToNix(event);
@@ -323,10 +1043,7 @@ void DesktopWindowLinux::handleXEvent(const XEvent& event)
     case ButtonPress: {
         const XButtonPressedEvent* xEvent = reinterpret_cast<const XButtonReleasedEvent*>(&event);
 
-        if (xEvent->button == 4 || xEvent->button == 5) {
-            // Same constant we use inside WebView to calculate the ticks. See also WebCore::Scrollbar::pixelsPerLineStep().
-            const float pixelsPerStep = 40.0f;
-
+        if (isWheelButton(xEvent->button)) {
             NIXWheelEvent ev;
             ev.type = kNIXInputEventTypeWheel;
             ev.modifiers = convertXEventModifiersToNativeModifiers(xEvent->state);
@@ -335,9 +1052,10 @@ void DesktopWindowLinux::handleXEvent(const XEvent& event)
             ev.y = xEvent->y;
             ev.globalX = xEvent->x_root;
             ev.globalY = xEvent->y_root;
-            ev.delta = pixelsPerStep * (xEvent->button == 4 ? 1 : -1);
-            ev.orientation = xEvent->state & Mod1Mask ? kNIXWheelEventOrientationHorizontal : kNIXWheelEventOrientationVertical;
-            m_client->onMouseWheel(&ev);
+            ev.delta = pixelsPerScrollStep * (xEvent->button == 4 || xEvent->button == 6 ? 1 : -1);
+            bool horizontal = xEvent->button >= 6 || xEvent->state & Mod1Mask;
+            ev.orientation = horizontal ? kNIXWheelEventOrientationHorizontal : kNIXWheelEventOrientationVertical;
+            queueMouseWheel(ev);
             break;
         }
         updateClickCount(xEvent);
@@ -357,7 +1075,8 @@ void DesktopWindowLinux::handleXEvent(const XEvent& event)
     }
     case ButtonRelease: {
         const XButtonReleasedEvent* xEvent = reinterpret_cast<const XButtonReleasedEvent*>(&event);
-        if (xEvent->button == 4 || xEvent->button == 5)
+        // Part of the notch, which was handled on press.
+        if (isWheelButton(xEvent->button))
             break;
 
         NIXMouseEvent ev;
@@ -390,12 +1109,86 @@ void DesktopWindowLinux::handleXEvent(const XEvent& event)
         ev.clickCount = 0;
         ev.modifiers = convertXEventModifiersToNativeModifiers(xEvent->state);
         ev.timestamp = convertXEventTimeToNixTimestamp(xEvent->time);
-        m_client->onMouseMove(&ev);
+        queueMouseMove(ev);
         break;
     }
     }
 }
 
+void DesktopWindowLinux::didHandleXEvents()
+{
+    sendQueuedMouseMove();
+    sendQueuedMouseWheel();
+}
+
+void DesktopWindowLinux::queueMouseMove(const NIXMouseEvent& event)
+{
+    // Only the latest position matters, the button and modifiers can't change without other
+    // events in between.
+    ++m_mouseMovesReceived;
+    if (m_hasQueuedMouseMove)
+        ++m_mouseMovesMerged;
+    else
+        m_queuedMouseMoveTime = m_inputEventTime;
+    m_queuedMouseMove = event;
+    m_hasQueuedMouseMove = true;
+}
+
+void DesktopWindowLinux::queueMouseWheel(NIXWheelEvent event)
+{
+    ++m_mouseWheelsReceived;
+    int orientation = event.orientation == kNIXWheelEventOrientationHorizontal;
+    NIXWheelEvent& queued = m_queuedMouseWheel[orientation];
+    if (m_hasQueuedMouseWheel[orientation]) {
+        if (queued.modifiers == event.modifiers) {
+            event.delta += queued.delta;
+            queued = event;
+            ++m_mouseWheelsMerged;
+            return;
+        }
+        sendQueuedMouseWheel();
+    }
+    queued = event;
+    m_hasQueuedMouseWheel[orientation] = true;
+    m_queuedMouseWheelTime[orientation] = m_inputEventTime;
+}
+
+void DesktopWindowLinux::sendQueuedMouseMove()
+{
+    if (!m_hasQueuedMouseMove)
+        return;
+    m_hasQueuedMouseMove = false;
+
+    // Held events may be sent while handling the next one, whose time must be kept.
+    int64_t eventTime = m_inputEventTime;
+    m_inputEventTime = m_queuedMouseMoveTime;
+    if (m_client)
+        m_client->onMouseMove(&m_queuedMouseMove);
+    m_inputEventTime = eventTime;
+}
+
+void DesktopWindowLinux::sendQueuedMouseWheel()
+{
+    int64_t eventTime = m_inputEventTime;
+    for (int orientation = 0; orientation < 2; ++orientation) {
+        if (!m_hasQueuedMouseWheel[orientation])
+            continue;
+        m_hasQueuedMouseWheel[orientation] = false;
+        m_inputEventTime = m_queuedMouseWheelTime[orientation];
+        if (m_client)
+            m_client->onMouseWheel(&m_queuedMouseWheel[orientation]);
+    }
+    m_inputEventTime = eventTime;
+}
+
+void DesktopWindowLinux::dumpStatistics(std::ostream& out) const
+{
+    out << "Input: " << m_mouseMovesReceived << " mouse moves, " << m_mouseMovesMerged << " merged; "
+        << m_mouseWheelsReceived << " wheel events, " << m_mouseWheelsMerged << " merged" << std::endl;
+    if (m_offscreen)
+        out << "MIT-SHM: " << m_sharedImageWaits << " presents waited for the server" << std::endl;
+}
+
 void DesktopWindowLinux::updateClickCount(const XButtonPressedEvent* event)
 {
     if (m_lastClickX != event->x
@@ -418,11 +1211,22 @@ void DesktopWindowLinux::updateSizeIfNeeded(int width, int height)
         return;
 
     m_size = WKSizeMake(width, height);
+    m_backBufferPreserved = false;
 
     if (m_client)
         m_client->onWindowSizeChange(m_size);
 }
 
+void DesktopWindowLinux::updateOcclusion()
+{
+    bool occluded = !m_mapped || m_fullyObscured;
+    if (occluded == m_occluded)
+        return;
+
+    m_occluded = occluded;
+    m_client->onWindowOcclusionChange(occluded);
+}
+
 void DesktopWindowLinux::setMouseCursor(unsigned shape)
 {
     static unsigned cursorShapes[] = {
@@ -513,3 +1317,8 @@ void DesktopWindowLinux::setPosition(const WKPoint& position)
     changes.y = position.y;
     XConfigureWindow(m_display, m_window, CWX | CWY, &changes);
 }
+
+void DesktopWindowLinux::setSize(const WKSize& size)
+{
+    XResizeWindow(m_display, m_window, size.width, size.height);
+}
@@ -25,27 +25,47 @@
 
 #include "XlibEventSource.h"
 
+#include "MainLoopScheduling.h"
 #include "assert.h"
 
+static const gint64 dispatchTimeBudget = 8000;
+
 struct WrappedGSource {
     GSource source;
     XlibEventSource* xlibEventSource;
 
     Display* display() { return xlibEventSource->m_display; }
     XlibEventSource::Client* client() { return xlibEventSource->m_client; }
+    const GPollFD& pollFD() { return xlibEventSource->m_pollFD; }
 };
 
-static gboolean eventSourceCheck(GSource* source)
+static gboolean eventSourcePrepare(GSource* source, gint* timeout)
 {
     WrappedGSource* wrappedSource = reinterpret_cast<WrappedGSource*>(source);
-    return XPending(wrappedSource->display());
-}
+    Display* display = wrappedSource->display();
 
-static gboolean eventSourcePrepare(GSource* source, gint* timeout)
-{
     if (timeout)
         *timeout = -1;
-    return eventSourceCheck(source);
+
+    // Requests still buffered must go out before polling, nothing is written when there are none.
+    // XFlush takes the display lock, the compositor thread sends GLX requests on the same display.
+    // Unlike XPending, QueuedAlready doesn't read from the connection, the poll tells if there's
+    // anything.
+    XFlush(display);
+    return XEventsQueued(display, QueuedAlready);
+}
+
+static gboolean eventSourceCheck(GSource* source)
+{
+    WrappedGSource* wrappedSource = reinterpret_cast<WrappedGSource*>(source);
+    Display* display = wrappedSource->display();
+
+    if (XEventsQueued(display, QueuedAlready))
+        return true;
+    // Only read when the poll says there's something, reading notices hang ups and errors as well.
+    if (wrappedSource->pollFD().revents & (G_IO_IN | G_IO_HUP | G_IO_ERR))
+        return XEventsQueued(display, QueuedAfterReading);
+    return false;
 }
 
 static gboolean eventSourceDispatch(GSource* source, GSourceFunc callback, gpointer user_data)
@@ -53,11 +73,21 @@ static gboolean eventSourceDispatch(GSource* source, GSourceFunc callback, gpoin
     WrappedGSource* wrappedSource = reinterpret_cast<WrappedGSource*>(source);
     Display* display = wrappedSource->display();
 
-    do {
-        XEvent event;
-        XNextEvent(display, &event);
-        wrappedSource->client()->handleXEvent(event);
-    } while (XPending(display));
+    // Events are handled in batches of whatever was already read, the connection is only read
+    // again, without blocking, once the queue is drained. A flood of events is left for the next
+    // iteration past a time budget, so that starving sources get the chance to be raised.
+    gint64 start = g_get_monotonic_time();
+    while (XEventsQueued(display, QueuedAfterReading)) {
+        do {
+            XEvent event;
+            XNextEvent(display, &event);
+            wrappedSource->client()->handleXEvent(event);
+        } while (XEventsQueued(display, QueuedAlready));
+        if (g_get_monotonic_time() - start > dispatchTimeBudget)
+            break;
+    }
+    wrappedSource->client()->didHandleXEvents();
+    accountDispatch(InputClass, start);
 
     if (callback)
         callback(user_data);
@@ -87,6 +117,7 @@ XlibEventSource::XlibEventSource(Display* display, Client* client)
     m_source = reinterpret_cast<WrappedGSource*>(g_source_new(&eventSourceFuncs, sizeof(WrappedGSource)));
     m_source->xlibEventSource = this;
 
+    g_source_set_priority(&m_source->source, schedulingPriority(InputClass));
     g_source_attach(&m_source->source, 0);
     g_source_add_poll(&m_source->source, &m_pollFD);
 }
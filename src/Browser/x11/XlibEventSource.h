@@ -33,11 +33,16 @@
 struct WrappedGSource;
 
 // Integrates Xlib events with the Glib event loop, by using an GSource for the Xlib connection.
+// Readiness comes from the poll of the connection and the events Xlib already queued, so idle
+// main loop iterations make no X calls reaching the socket.
 class XlibEventSource {
 public:
     class Client {
     public:
         virtual void handleXEvent(const XEvent&) = 0;
+        // Called once all the events pending were handled, clients holding back events to merge
+        // them with the following ones must send them now.
+        virtual void didHandleXEvents() = 0;
     };
 
     XlibEventSource(Display*, Client*);
@@ -32,11 +32,20 @@
 #include <ctype.h>
 #include <glib.h>
 
-static NIXKeyEventKey convertXKeySymToNativeKeycode(unsigned int keysym)
+static inline NIXKeyEventKey convertXKeySymToNativeKeycode(unsigned int keysym)
 {
-    for (int i = 0; XKeySymMappingTable[i]; i += 2) {
-        if (XKeySymMappingTable[i] == keysym)
-            return static_cast<NIXKeyEventKey>(XKeySymMappingTable[i+1]);
+    // Binary search, called for every key press and release, auto-repeated ones included.
+    unsigned begin = 0;
+    unsigned end = XKeySymMappingTableSize;
+    while (begin < end) {
+        unsigned middle = (begin + end) / 2;
+        unsigned current = XKeySymMappingTable[2 * middle];
+        if (current == keysym)
+            return static_cast<NIXKeyEventKey>(XKeySymMappingTable[2 * middle + 1]);
+        if (current < keysym)
+            begin = middle + 1;
+        else
+            end = middle;
     }
 
     if (keysym < 256) {
@@ -55,7 +64,7 @@ static NIXKeyEventKey convertXKeySymToNativeKeycode(unsigned int keysym)
     return kNIXKeyEventKey_unknown;
 }
 
-static uint32_t convertXEventModifiersToNativeModifiers(int s)
+static inline uint32_t convertXEventModifiersToNativeModifiers(int s)
 {
     int ret = 0;
     if (s & ShiftMask)
@@ -73,7 +82,7 @@ static uint32_t convertXEventModifiersToNativeModifiers(int s)
     return ret;
 }
 
-static WKEventMouseButton convertXEventButtonToNativeMouseButton(unsigned int mouseButton)
+static inline WKEventMouseButton convertXEventButtonToNativeMouseButton(unsigned int mouseButton)
 {
     switch (mouseButton) {
     case Button1:
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Times keysym lookups through the binary search against the linear scan it replaced, over the
+// keys typed most, which the scan finds first, and the ones it finds last or never.
+
+#include "LegacyXKeyMapping.h"
+#include <X11/Xlib.h>
+#include "XlibEventUtils.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+static const unsigned iterations = 2000000;
+
+template<typename Lookup>
+static double nanosecondsPerLookup(const std::vector<unsigned>& keysyms, Lookup lookup)
+{
+    // Summed so the lookups can't be optimized away.
+    unsigned long sum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < iterations; ++i)
+        sum += lookup(keysyms[i % keysyms.size()]);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    if (sum == 1)
+        std::cerr << sum;
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static void run(const char* name, const std::vector<unsigned>& keysyms)
+{
+    double linear = nanosecondsPerLookup(keysyms, legacyConvertXKeySymToNativeKeycode);
+    double binary = nanosecondsPerLookup(keysyms, convertXKeySymToNativeKeycode);
+    std::cout << name << ": linear scan " << linear << "ns, binary search " << binary << "ns" << std::endl;
+}
+
+int main()
+{
+    std::vector<unsigned> typing;
+    for (unsigned keysym = 'a'; keysym <= 'z'; ++keysym)
+        typing.push_back(keysym);
+    typing.push_back(XK_space);
+    typing.push_back(XK_BackSpace);
+    typing.push_back(XK_Return);
+    typing.push_back(XK_Shift_L);
+    run("Typing", typing);
+
+    std::vector<unsigned> tableKeys;
+    for (unsigned i = 0; i < XKeySymMappingTableSize; ++i)
+        tableKeys.push_back(XKeySymMappingTable[2 * i]);
+    run("Table keys", tableKeys);
+
+    std::vector<unsigned> lateKeys = { XK_dead_hook, XK_dead_horn, XK_F5, XK_KP_5 };
+    run("Dead, function and keypad keys", lateKeys);
+    return 0;
+}
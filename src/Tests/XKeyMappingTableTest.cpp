@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2012-2013 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Checks that the binary search over the sorted keysym table maps every keysym to the same key as
+// the linear scan of the table it replaced.
+
+#include "LegacyXKeyMapping.h"
+#include <X11/Xlib.h>
+#include "XlibEventUtils.h"
+#include <iostream>
+#include <set>
+
+int main()
+{
+    std::set<unsigned> keysyms;
+    // Every keysym of the core and extension sets, mapped or not.
+    for (unsigned keysym = 0; keysym <= 0xffff; ++keysym)
+        keysyms.insert(keysym);
+    // Both tables' entries and their unmapped neighbours, which catches vendor keysyms off by one.
+    for (unsigned i = 0; legacyXKeySymMappingTable[i]; i += 2) {
+        for (int offset = -2; offset <= 2; ++offset)
+            keysyms.insert(legacyXKeySymMappingTable[i] + offset);
+    }
+    for (unsigned i = 0; i < XKeySymMappingTableSize; ++i) {
+        for (int offset = -2; offset <= 2; ++offset)
+            keysyms.insert(XKeySymMappingTable[2 * i] + offset);
+    }
+    keysyms.insert(0xffffffff);
+
+    unsigned failures = 0;
+    for (unsigned keysym : keysyms) {
+        NIXKeyEventKey expected = legacyConvertXKeySymToNativeKeycode(keysym);
+        NIXKeyEventKey key = convertXKeySymToNativeKeycode(keysym);
+        if (key == expected)
+            continue;
+        std::cerr << std::hex << "keysym 0x" << keysym << " maps to 0x" << key << " instead of 0x" << expected << std::endl;
+        ++failures;
+    }
+
+    std::cout << keysyms.size() << " keysyms checked, " << failures << " mismatches" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+keyMappingTest = Executable:new("XKeyMappingTableTest")
+keyMappingTest:use(nix)
+keyMappingTest:use(glib)
+keyMappingTest:use(x11)
+keyMappingTest:addIncludePath("../Browser/x11")
+keyMappingTest:addFiles("XKeyMappingTableTest.cpp")
+
+keyMappingBenchmark = Executable:new("XKeyMappingTableBenchmark")
+keyMappingBenchmark:use(nix)
+keyMappingBenchmark:use(glib)
+keyMappingBenchmark:use(x11)
+keyMappingBenchmark:addIncludePath("../Browser/x11")
+keyMappingBenchmark:addFiles("XKeyMappingTableBenchmark.cpp")
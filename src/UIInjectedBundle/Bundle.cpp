@@ -111,11 +111,14 @@ void Bundle::registerAPI()
         "_requestTab",
         "_closeTab",
         "_toolBarHeightChanged",
+        "_popupHeightChanged",
         "_loadUrl",
         "_setCurrentTab",
         "_back",
         "_forward",
         "_reload",
+        "_captureScreenshot",
+        "_dumpStatistics",
         0
     };
     for (int i = 0; funcs[i]; ++i)
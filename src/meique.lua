@@ -1,6 +1,12 @@
 glib = findPackage("glib-2.0", REQUIRED)
+cairo = findPackage("cairo", REQUIRED)
 openGL = findPackage("gl", REQUIRED)
+egl = findPackage("egl", REQUIRED)
+gstreamer = findPackage("gstreamer-1.0", REQUIRED)
+gstreamerApp = findPackage("gstreamer-app-1.0", REQUIRED)
 x11 = findPackage("x11", REQUIRED)
+xext = findPackage("xext", REQUIRED)
+xi = findPackage("xi", REQUIRED)
 nix = findPackage("WebKitNix", REQUIRED)
 
 addCustomFlags("-std=c++0x")
@@ -8,3 +14,4 @@ addCustomFlags("-std=c++0x")
 addSubdirectory("Browser")
 addSubdirectory("ContentsInjectedBundle")
 addSubdirectory("UIInjectedBundle")
+addSubdirectory("Tests")